@@ -0,0 +1,193 @@
+/* bench.h - utils for super simple microbenchmarks
+ *
+ * Usage:
+ *   BENCH_HEADING("strbuf");
+ *   BENCH("sbaddc", 1000, sbaddc(&sb, 'x'));
+ *   BENCH("printu", 1000, n = printu(buf, 12345); DONOTOPTIMIZE(n));
+ *   BENCH("sbtrunc", 1000, sbtrunc(&sb, 0); CLOBBER());
+ *   BENCHBYTES("utf8len", 1000, len, n = utf8len(text, len); DONOTOPTIMIZE(n));
+ *
+ * BENCH runs the statements (the 3rd argument) iterations times
+ * to warm up, and then BENCH_SAMPLES more times iterations times,
+ * timing each sample with clock_gettime(CLOCK_MONOTONIC), and with
+ * RDTSC on x86 if bench.cycles is set. It reports the time per
+ * iteration: the median and the 10th and 90th percentile of the
+ * samples, and the minimum. The median is robust against the odd
+ * sample hit by an interrupt; a large spread between p10 and p90
+ * means the results are noisy (try more iterations). BENCHBYTES
+ * also reports the time per byte, for statements that process
+ * the given number of bytes per iteration.
+ *
+ * DONOTOPTIMIZE(x) makes the compiler believe that the value x is
+ * used, so that the computation of x is not optimized away; CLOBBER()
+ * makes it believe that all memory is read and written, so that
+ * stores are not optimized away. Both generate no code.
+ *
+ * With bench.tsv set, the output is tab-separated values, one line
+ * per benchmark (suite, name, iterations, median, p10, p90, min
+ * in ns, median in cycles or 0, bytes, median ns per byte or 0, and
+ * the counters below), after a header line. If bench.filter
+ * is set, only benchmarks whose name contains it are run. The output
+ * goes to bench.out, or to stdout if that is null.
+ *
+ * If bench.perf points to hardware counters opened by perfctr_open
+ * (see perfctr.h; this needs perfctr.o from the library), they count
+ * over all samples, and the report adds IPC (instructions per cycle)
+ * and, per iteration (or per byte), cycles, instructions, branch
+ * misses, and L1d and LLC misses. Counters that could not be opened
+ * are reported as -1 (or left out).
+ *
+ * Requires _POSIX_C_SOURCE >= 199309L for clock_gettime.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "perfctr.h"
+
+#ifndef BENCH_SAMPLES
+# define BENCH_SAMPLES 21
+#endif
+
+#if defined(__GNUC__)
+# define DONOTOPTIMIZE(x) __asm__ __volatile__("" : : "g" (x) : "memory")
+# define CLOBBER() __asm__ __volatile__("" : : : "memory")
+#else
+# define DONOTOPTIMIZE(x) do { static volatile int sink_; sink_ = (int) (x); } while (0)
+# define CLOBBER() do { } while (0)
+#endif
+
+static struct {
+  int tsv;                /* tab-separated output */
+  int cycles;             /* also count cycles (x86 only) */
+  const char *filter;     /* only names containing this */
+  const char *suite;      /* from BENCH_HEADING */
+  int headed;             /* suite heading printed */
+  FILE *out;              /* or null for stdout */
+  perfctr *perf;          /* hardware counters, or null */
+  int header;             /* tsv header printed */
+  double ns[BENCH_SAMPLES];
+  double cyc[BENCH_SAMPLES];
+} bench;
+
+#define BENCH_OUT (bench.out ? bench.out : stdout)
+
+#define BENCH_HEADING(s) \
+  do { \
+    bench.suite = (s); \
+    bench.headed = 0; /* printed with the first result */ \
+  } while (0)
+
+#define BENCH(name, iterations, stmts) BENCHBYTES(name, iterations, 0, stmts)
+
+#define BENCHBYTES(name, iterations, bytes, stmts) \
+  do { \
+    long n_ = (iterations), i_; \
+    int s_; \
+    double t_; \
+    uint64_t c_; \
+    if (bench.filter && !strstr((name), bench.filter)) break; \
+    for (i_ = 0; i_ < n_; i_++) { stmts; CLOBBER(); } \
+    if (bench.perf) perfctr_start(bench.perf); \
+    for (s_ = 0; s_ < BENCH_SAMPLES; s_++) { \
+      t_ = bench_now(); \
+      c_ = bench_rdtsc(); \
+      for (i_ = 0; i_ < n_; i_++) { stmts; CLOBBER(); } \
+      bench.cyc[s_] = (double) (bench_rdtsc() - c_) / n_; \
+      bench.ns[s_] = (bench_now() - t_) * 1e9 / n_; \
+    } \
+    if (bench.perf) perfctr_stop(bench.perf); \
+    bench_report((name), n_, (bytes)); \
+  } while (0)
+
+static double
+bench_now(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double) ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static uint64_t
+bench_rdtsc(void)
+{
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+  uint32_t lo, hi;
+  if (!bench.cycles) return 0;
+  __asm__ __volatile__("rdtsc" : "=a" (lo), "=d" (hi));
+  return (uint64_t) hi << 32 | lo;
+#else
+  return 0;
+#endif
+}
+
+static int
+bench_cmp(const void *a, const void *b)
+{
+  double x = *(const double *) a, y = *(const double *) b;
+  return (x > y) - (x < y);
+}
+
+static double
+bench_pct(const double sorted[], int p)
+{ /* p-th percentile of the sorted samples (nearest rank) */
+  return sorted[(p * (BENCH_SAMPLES - 1) + 50) / 100];
+}
+
+static double
+bench_count(int which, double per)
+{ /* hardware counter per iteration or byte, or -1 if not available */
+  if (!bench.perf || bench.perf->fd[which] < 0) return -1;
+  return (double) bench.perf->value[which] / per;
+}
+
+static void
+bench_report(const char *name, long iterations, size_t bytes)
+{
+  double per = (double) iterations * BENCH_SAMPLES * (bytes ? bytes : 1);
+  double ipc = -1;
+  int i;
+
+  qsort(bench.ns, BENCH_SAMPLES, sizeof bench.ns[0], bench_cmp);
+  qsort(bench.cyc, BENCH_SAMPLES, sizeof bench.cyc[0], bench_cmp);
+  if (bench_count(PERFCTR_CYCLES, 1) > 0 && bench_count(PERFCTR_INSTRUCTIONS, 1) >= 0)
+    ipc = bench_count(PERFCTR_INSTRUCTIONS, 1) / bench_count(PERFCTR_CYCLES, 1);
+
+  if (bench.tsv) {
+    if (!bench.header++) {
+      fprintf(BENCH_OUT, "suite\tname\titerations\tmedian_ns\tp10_ns\tp90_ns\tmin_ns\tmedian_cycles"
+                         "\tbytes\tns_per_byte\tipc");
+      for (i = 0; i < PERFCTR_MAX; i++) fprintf(BENCH_OUT, "\t%s", perfctr_name(i));
+      fprintf(BENCH_OUT, "\n");
+    }
+    fprintf(BENCH_OUT, "%s\t%s\t%ld\t%.3f\t%.3f\t%.3f\t%.3f\t%.1f\t%lu\t%.4f\t%.3f",
+            bench.suite ? bench.suite : "", name, iterations,
+            bench_pct(bench.ns, 50), bench_pct(bench.ns, 10),
+            bench_pct(bench.ns, 90), bench.ns[0], bench_pct(bench.cyc, 50),
+            (unsigned long) bytes, bytes ? bench_pct(bench.ns, 50) / bytes : 0, ipc);
+    for (i = 0; i < PERFCTR_MAX; i++) fprintf(BENCH_OUT, "\t%.4f", bench_count(i, per));
+    fprintf(BENCH_OUT, "\n");
+  }
+  else {
+    if (!bench.headed++ && bench.suite) fprintf(BENCH_OUT, "%s\n", bench.suite);
+    fprintf(BENCH_OUT, "  %-28s %10.2f ns  (p10 %.2f, p90 %.2f, min %.2f)",
+            name, bench_pct(bench.ns, 50), bench_pct(bench.ns, 10),
+            bench_pct(bench.ns, 90), bench.ns[0]);
+    if (bench.cycles) fprintf(BENCH_OUT, " %.1f cycles", bench_pct(bench.cyc, 50));
+    fprintf(BENCH_OUT, "\n");
+    if (bytes)
+      fprintf(BENCH_OUT, "  %28s %10.3f ns/byte (%.2f GB/s)\n", "",
+              bench_pct(bench.ns, 50) / bytes, bytes / bench_pct(bench.ns, 50));
+    if (bench.perf && bench.perf->n > 0) {
+      fprintf(BENCH_OUT, "  %28s IPC %.2f, per %s:", "", ipc, bytes ? "byte" : "iteration");
+      for (i = 0; i < PERFCTR_MAX; i++)
+        if (bench.perf->fd[i] >= 0)
+          fprintf(BENCH_OUT, " %.3g %s", bench_count(i, per), perfctr_name(i));
+      fprintf(BENCH_OUT, "\n");
+    }
+  }
+  fflush(BENCH_OUT);
+}
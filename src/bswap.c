@@ -0,0 +1,104 @@
+#include "byteorder.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSSE3__)
+#include <tmmintrin.h>
+#endif
+
+/* Byte swap arrays of 16, 32, or 64 bit values
+ *
+ * With SSSE3, PSHUFB reverses the bytes within each element of a
+ * 16 byte block in one instruction (the shuffle mask selects the
+ * source byte for each destination byte); with AVX2, VPSHUFB does
+ * two such blocks at once, and the loop handles 64 bytes per step.
+ * The tail (fewer than 16 bytes) is done one element at a time.
+ * Each block is loaded before it is stored, so dst may be src.
+ */
+
+#if defined(__SSSE3__)
+static size_t
+shuffle(unsigned char *d, const unsigned char *s, size_t nbytes, int width)
+{ /* reverse each width bytes in 16 byte blocks; return #bytes done */
+  size_t i = 0;
+  __m128i mask;
+
+  mask = width == 2 ? _mm_setr_epi8(1,0, 3,2, 5,4, 7,6, 9,8, 11,10, 13,12, 15,14) :
+         width == 4 ? _mm_setr_epi8(3,2,1,0, 7,6,5,4, 11,10,9,8, 15,14,13,12) :
+         _mm_setr_epi8(7,6,5,4,3,2,1,0, 15,14,13,12,11,10,9,8);
+
+#if defined(__AVX2__)
+  {
+    __m256i mask2 = _mm256_broadcastsi128_si256(mask);
+    for (; i + 64 <= nbytes; i += 64) {
+      __m256i v0 = _mm256_loadu_si256((const __m256i *) (s + i));
+      __m256i v1 = _mm256_loadu_si256((const __m256i *) (s + i + 32));
+      _mm256_storeu_si256((__m256i *) (d + i), _mm256_shuffle_epi8(v0, mask2));
+      _mm256_storeu_si256((__m256i *) (d + i + 32), _mm256_shuffle_epi8(v1, mask2));
+    }
+  }
+#endif
+  for (; i + 16 <= nbytes; i += 16) {
+    __m128i v = _mm_loadu_si128((const __m128i *) (s + i));
+    _mm_storeu_si128((__m128i *) (d + i), _mm_shuffle_epi8(v, mask));
+  }
+  return i;
+}
+#endif
+
+/** Swap the bytes of n 16 bit values from src into dst */
+void
+bswap_array16(void *dst, const void *src, size_t n)
+{
+  unsigned char *d = (unsigned char *) dst;
+  const unsigned char *s = (const unsigned char *) src;
+  size_t i = 0;
+  uint16_t x;
+
+#if defined(__SSSE3__)
+  i = shuffle(d, s, 2*n, 2) / 2;
+#endif
+  for (; i < n; i++) {
+    memcpy(&x, s + 2*i, sizeof x);
+    x = bswap16(x);
+    memcpy(d + 2*i, &x, sizeof x);
+  }
+}
+
+/** Swap the bytes of n 32 bit values from src into dst */
+void
+bswap_array32(void *dst, const void *src, size_t n)
+{
+  unsigned char *d = (unsigned char *) dst;
+  const unsigned char *s = (const unsigned char *) src;
+  size_t i = 0;
+  uint32_t x;
+
+#if defined(__SSSE3__)
+  i = shuffle(d, s, 4*n, 4) / 4;
+#endif
+  for (; i < n; i++) {
+    memcpy(&x, s + 4*i, sizeof x);
+    x = bswap32(x);
+    memcpy(d + 4*i, &x, sizeof x);
+  }
+}
+
+/** Swap the bytes of n 64 bit values from src into dst */
+void
+bswap_array64(void *dst, const void *src, size_t n)
+{
+  unsigned char *d = (unsigned char *) dst;
+  const unsigned char *s = (const unsigned char *) src;
+  size_t i = 0;
+  uint64_t x;
+
+#if defined(__SSSE3__)
+  i = shuffle(d, s, 8*n, 8) / 8;
+#endif
+  for (; i < n; i++) {
+    memcpy(&x, s + 8*i, sizeof x);
+    x = bswap64(x);
+    memcpy(d + 8*i, &x, sizeof x);
+  }
+}
@@ -0,0 +1,228 @@
+/* Byte order: compile-time endianness, byte swapping,
+ * and loads/stores of little and big endian integers */
+
+#ifndef BYTEORDER_H
+#define BYTEORDER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#define ENDIAN_LITTLE  1    /* same as in myutils.h */
+#define ENDIAN_BIG     2
+
+/* ENDIAN_NATIVE is ENDIAN_LITTLE or ENDIAN_BIG if known at
+ * compile time, otherwise 0 (then use getendian() from myutils.h) */
+#if defined(__BYTE_ORDER__) && defined(__ORDER_LITTLE_ENDIAN__) && \
+    __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#define ENDIAN_NATIVE ENDIAN_LITTLE
+#elif defined(__BYTE_ORDER__) && defined(__ORDER_BIG_ENDIAN__) && \
+    __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+#define ENDIAN_NATIVE ENDIAN_BIG
+#elif defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define ENDIAN_NATIVE ENDIAN_LITTLE
+#else
+#define ENDIAN_NATIVE 0
+#endif
+
+/* The helpers below are static inline so that each compiles to
+ * a plain load or store plus a BSWAP (or one MOVBE with -mmovbe).
+ * If the byte order is not known at compile time, they assemble
+ * the bytes one by one, which works on any machine. */
+
+static inline uint16_t
+bswap16(uint16_t x)
+{
+#if defined(__GNUC__)
+  return __builtin_bswap16(x);
+#else
+  return (uint16_t) (x << 8 | x >> 8);
+#endif
+}
+
+static inline uint32_t
+bswap32(uint32_t x)
+{
+#if defined(__GNUC__)
+  return __builtin_bswap32(x);
+#else
+  x = (x & 0x00FF00FFu) << 8 | (x >> 8 & 0x00FF00FFu);
+  return x << 16 | x >> 16;
+#endif
+}
+
+static inline uint64_t
+bswap64(uint64_t x)
+{
+#if defined(__GNUC__)
+  return __builtin_bswap64(x);
+#else
+  return (uint64_t) bswap32((uint32_t) x) << 32 | bswap32((uint32_t) (x >> 32));
+#endif
+}
+
+static inline uint16_t
+load_le16(const void *p)
+{
+#if ENDIAN_NATIVE
+  uint16_t x;
+  memcpy(&x, p, sizeof x);
+  return ENDIAN_NATIVE == ENDIAN_LITTLE ? x : bswap16(x);
+#else
+  const unsigned char *b = (const unsigned char *) p;
+  return (uint16_t) (b[0] | b[1] << 8);
+#endif
+}
+
+static inline uint32_t
+load_le32(const void *p)
+{
+#if ENDIAN_NATIVE
+  uint32_t x;
+  memcpy(&x, p, sizeof x);
+  return ENDIAN_NATIVE == ENDIAN_LITTLE ? x : bswap32(x);
+#else
+  const unsigned char *b = (const unsigned char *) p;
+  return (uint32_t) b[0] | (uint32_t) b[1] << 8 |
+         (uint32_t) b[2] << 16 | (uint32_t) b[3] << 24;
+#endif
+}
+
+static inline uint64_t
+load_le64(const void *p)
+{
+#if ENDIAN_NATIVE
+  uint64_t x;
+  memcpy(&x, p, sizeof x);
+  return ENDIAN_NATIVE == ENDIAN_LITTLE ? x : bswap64(x);
+#else
+  const unsigned char *b = (const unsigned char *) p;
+  return (uint64_t) load_le32(b) | (uint64_t) load_le32(b + 4) << 32;
+#endif
+}
+
+static inline uint16_t
+load_be16(const void *p)
+{
+#if ENDIAN_NATIVE
+  uint16_t x;
+  memcpy(&x, p, sizeof x);
+  return ENDIAN_NATIVE == ENDIAN_BIG ? x : bswap16(x);
+#else
+  const unsigned char *b = (const unsigned char *) p;
+  return (uint16_t) (b[0] << 8 | b[1]);
+#endif
+}
+
+static inline uint32_t
+load_be32(const void *p)
+{
+#if ENDIAN_NATIVE
+  uint32_t x;
+  memcpy(&x, p, sizeof x);
+  return ENDIAN_NATIVE == ENDIAN_BIG ? x : bswap32(x);
+#else
+  const unsigned char *b = (const unsigned char *) p;
+  return (uint32_t) b[0] << 24 | (uint32_t) b[1] << 16 |
+         (uint32_t) b[2] << 8 | (uint32_t) b[3];
+#endif
+}
+
+static inline uint64_t
+load_be64(const void *p)
+{
+#if ENDIAN_NATIVE
+  uint64_t x;
+  memcpy(&x, p, sizeof x);
+  return ENDIAN_NATIVE == ENDIAN_BIG ? x : bswap64(x);
+#else
+  const unsigned char *b = (const unsigned char *) p;
+  return (uint64_t) load_be32(b) << 32 | (uint64_t) load_be32(b + 4);
+#endif
+}
+
+static inline void
+store_le16(void *p, uint16_t x)
+{
+#if ENDIAN_NATIVE
+  if (ENDIAN_NATIVE != ENDIAN_LITTLE) x = bswap16(x);
+  memcpy(p, &x, sizeof x);
+#else
+  unsigned char *b = (unsigned char *) p;
+  b[0] = (unsigned char) x;
+  b[1] = (unsigned char) (x >> 8);
+#endif
+}
+
+static inline void
+store_le32(void *p, uint32_t x)
+{
+#if ENDIAN_NATIVE
+  if (ENDIAN_NATIVE != ENDIAN_LITTLE) x = bswap32(x);
+  memcpy(p, &x, sizeof x);
+#else
+  unsigned char *b = (unsigned char *) p;
+  store_le16(b, (uint16_t) x);
+  store_le16(b + 2, (uint16_t) (x >> 16));
+#endif
+}
+
+static inline void
+store_le64(void *p, uint64_t x)
+{
+#if ENDIAN_NATIVE
+  if (ENDIAN_NATIVE != ENDIAN_LITTLE) x = bswap64(x);
+  memcpy(p, &x, sizeof x);
+#else
+  unsigned char *b = (unsigned char *) p;
+  store_le32(b, (uint32_t) x);
+  store_le32(b + 4, (uint32_t) (x >> 32));
+#endif
+}
+
+static inline void
+store_be16(void *p, uint16_t x)
+{
+#if ENDIAN_NATIVE
+  if (ENDIAN_NATIVE != ENDIAN_BIG) x = bswap16(x);
+  memcpy(p, &x, sizeof x);
+#else
+  unsigned char *b = (unsigned char *) p;
+  b[0] = (unsigned char) (x >> 8);
+  b[1] = (unsigned char) x;
+#endif
+}
+
+static inline void
+store_be32(void *p, uint32_t x)
+{
+#if ENDIAN_NATIVE
+  if (ENDIAN_NATIVE != ENDIAN_BIG) x = bswap32(x);
+  memcpy(p, &x, sizeof x);
+#else
+  unsigned char *b = (unsigned char *) p;
+  store_be16(b, (uint16_t) (x >> 16));
+  store_be16(b + 2, (uint16_t) x);
+#endif
+}
+
+static inline void
+store_be64(void *p, uint64_t x)
+{
+#if ENDIAN_NATIVE
+  if (ENDIAN_NATIVE != ENDIAN_BIG) x = bswap64(x);
+  memcpy(p, &x, sizeof x);
+#else
+  unsigned char *b = (unsigned char *) p;
+  store_be32(b, (uint32_t) (x >> 32));
+  store_be32(b + 4, (uint32_t) x);
+#endif
+}
+
+/* Swap the bytes of n 16/32/64 bit values from src into dst (which
+ * may be src, but must not overlap it otherwise); no alignment needed */
+void bswap_array16(void *dst, const void *src, size_t n);
+void bswap_array32(void *dst, const void *src, size_t n);
+void bswap_array64(void *dst, const void *src, size_t n);
+
+#endif
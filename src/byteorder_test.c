@@ -0,0 +1,81 @@
+/* Unit tests for byteorder.h */
+
+#include "test.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#include "byteorder.h"
+#include "myutils.h"
+
+void
+byteorder_test(int *pnumpass, int *pnumfail)
+{
+  int numpass = 0;
+  int numfail = 0;
+
+  const unsigned char b[8] = {1, 2, 3, 4, 5, 6, 7, 8};
+  unsigned char out[9], src[200], dst[200], ref[200];
+  int i, j, n, ok;
+
+  HEADING("Testing byteorder");
+
+  TEST("native", ENDIAN_NATIVE == 0 || ENDIAN_NATIVE == getendian());
+  TEST("getendian", getendian() == ENDIAN_LITTLE || getendian() == ENDIAN_BIG);
+
+  TEST("bswap16", bswap16(0x0102) == 0x0201);
+  TEST("bswap32", bswap32(0x01020304) == 0x04030201);
+  TEST("bswap64", bswap64(UINT64_C(0x0102030405060708)) == UINT64_C(0x0807060504030201));
+
+  TEST("load_le16", load_le16(b) == 0x0201);
+  TEST("load_le32", load_le32(b) == 0x04030201);
+  TEST("load_le64", load_le64(b) == UINT64_C(0x0807060504030201));
+  TEST("load_be16", load_be16(b) == 0x0102);
+  TEST("load_be32", load_be32(b) == 0x01020304);
+  TEST("load_be64", load_be64(b) == UINT64_C(0x0102030405060708));
+  TEST("load unaligned", load_be32(b + 1) == 0x02030405 && load_le16(b + 3) == 0x0504);
+
+  memset(out, 0, sizeof out);
+  store_le16(out, 0x0201);
+  TEST("store_le16", memcmp(out, b, 2) == 0);
+  store_le32(out + 1, 0x05040302);
+  TEST("store_le32", memcmp(out + 1, b + 1, 4) == 0 && out[0] == 1);
+  store_le64(out, UINT64_C(0x0807060504030201));
+  TEST("store_le64", memcmp(out, b, 8) == 0);
+  memset(out, 0, sizeof out);
+  store_be16(out, 0x0102);
+  TEST("store_be16", memcmp(out, b, 2) == 0);
+  store_be32(out, 0x01020304);
+  TEST("store_be32", memcmp(out, b, 4) == 0);
+  store_be64(out + 1, UINT64_C(0x0102030405060708));
+  TEST("store_be64", memcmp(out + 1, b, 8) == 0);
+
+  for (i = 0; i < (int) sizeof src; i++) src[i] = (unsigned char) (i * 7 + 1);
+  for (ok = 1, n = 0; n <= 24; n++) { /* all tail lengths, unaligned */
+    int w;
+    for (w = 2; w <= 8; w *= 2) {
+      memset(dst, 0, sizeof dst);
+      memset(ref, 0, sizeof ref);
+      for (i = 0; i < n; i++)
+        for (j = 0; j < w; j++) ref[1 + i*w + j] = src[1 + i*w + w-1-j];
+      if (w == 2) bswap_array16(dst + 1, src + 1, n);
+      if (w == 4) bswap_array32(dst + 1, src + 1, n);
+      if (w == 8) bswap_array64(dst + 1, src + 1, n);
+      ok &= memcmp(dst, ref, sizeof dst) == 0;
+    }
+  }
+  TEST("bswap_array", ok);
+
+  memcpy(dst, src, sizeof dst);
+  bswap_array32(dst, dst, 50);
+  bswap_array32(ref, src, 50);
+  TEST("bswap_array in place", memcmp(dst, ref, sizeof dst) == 0);
+  bswap_array64(dst, dst, 25);
+  bswap_array64(ref, ref, 25);
+  bswap_array16(dst, dst, 100);
+  bswap_array16(ref, ref, 100);
+  TEST("bswap_array in place 2", memcmp(dst, ref, sizeof dst) == 0);
+
+  *pnumpass += numpass;
+  *pnumfail += numfail;
+}
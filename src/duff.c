@@ -1,4 +1,20 @@
-/* Duff's Device */
+/* Duff's Device, and a benchmark of copy loops */
+
+/* required for clock_gettime */
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "myutils.h"
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
 /* Emit count shorts to given port address */
 void emitdata(short *to, short *from, int count)
@@ -25,14 +41,179 @@ void unrolled(short *to, short *from, int count)
   }
 }
 
-int main()
+/* The copy loops to compare: copy n bytes, n a multiple of 16 */
+
+static void
+loopcopy(void *dst, const void *src, size_t n)
+{ /* simple loop, a word at a time */
+  long *to = (long *) dst;
+  const long *from = (const long *) src;
+  size_t count = n / sizeof (long);
+  while (count-- > 0) *to++ = *from++;
+}
+
+static void
+duffcopy(void *dst, const void *src, size_t n)
+{ /* Duff's device, memory to memory */
+  long *to = (long *) dst;
+  const long *from = (const long *) src;
+  size_t count = n / sizeof (long);
+  size_t k = (count+7)/8;
+  if (count == 0) return;
+  switch (count % 8) {
+  case 0: do { *to++ = *from++; /*FALLTHRU*/
+  case 7:      *to++ = *from++; /*FALLTHRU*/
+  case 6:      *to++ = *from++; /*FALLTHRU*/
+  case 5:      *to++ = *from++; /*FALLTHRU*/
+  case 4:      *to++ = *from++; /*FALLTHRU*/
+  case 3:      *to++ = *from++; /*FALLTHRU*/
+  case 2:      *to++ = *from++; /*FALLTHRU*/
+  case 1:      *to++ = *from++; /*FALLTHRU*/
+          } while (--k > 0);
+  }
+}
+
+static void
+libcopy(void *dst, const void *src, size_t n)
+{
+  memcpy(dst, src, n);
+}
+
+#if defined(__SSE2__)
+static void
+ssecopy(void *dst, const void *src, size_t n)
+{ /* 16 byte loads and stores */
+  char *d = (char *) dst;
+  const char *s = (const char *) src;
+  for (; n >= 16; n -= 16, d += 16, s += 16)
+    _mm_storeu_si128((__m128i *) d, _mm_loadu_si128((const __m128i *) s));
+}
+
+static void
+ssestream(void *dst, const void *src, size_t n)
+{ /* 16 byte non-temporal stores (dst is 16 byte aligned) */
+  char *d = (char *) dst;
+  const char *s = (const char *) src;
+  for (; n >= 16; n -= 16, d += 16, s += 16)
+    _mm_stream_si128((__m128i *) d, _mm_loadu_si128((const __m128i *) s));
+  _mm_sfence();
+}
+#endif
+
+#if defined(__AVX__)
+static void
+avxcopy(void *dst, const void *src, size_t n)
+{ /* 32 byte loads and stores */
+  char *d = (char *) dst;
+  const char *s = (const char *) src;
+  for (; n >= 32; n -= 32, d += 32, s += 32)
+    _mm256_storeu_si256((__m256i *) d, _mm256_loadu_si256((const __m256i *) s));
+  if (n) ssecopy(d, s, n);
+}
+
+static void
+avxstream(void *dst, const void *src, size_t n)
+{ /* 32 byte non-temporal stores (dst is 32 byte aligned) */
+  char *d = (char *) dst;
+  const char *s = (const char *) src;
+  for (; n >= 32; n -= 32, d += 32, s += 32)
+    _mm256_stream_si256((__m256i *) d, _mm256_loadu_si256((const __m256i *) s));
+  if (n) ssestream(d, s, n);
+  _mm_sfence();
+}
+#endif
+
+static void
+fast(void *dst, const void *src, size_t n)
+{
+  fastcopy(dst, src, n);
+}
+
+static const struct {
+  const char *name;
+  void (*copy)(void *dst, const void *src, size_t n);
+} methods[] = {
+  { "loop", loopcopy },
+  { "duff", duffcopy },
+  { "memcpy", libcopy },
+#if defined(__SSE2__)
+  { "sse", ssecopy },
+  { "sse-nt", ssestream },
+#endif
+#if defined(__AVX__)
+  { "avx", avxcopy },
+  { "avx-nt", avxstream },
+#endif
+  { "fastcopy", fast },
+};
+
+#define NMETHODS (sizeof methods / sizeof methods[0])
+#define MINSIZE 16
+#define WORK (256UL << 20)  /* bytes to copy per size and method */
+
+static double
+now(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static size_t
+parsesize(const char *s)
+{ /* number with optional K, M, G suffix */
+  char *end;
+  unsigned long n = strtoul(s, &end, 10);
+  switch (*end) {
+  case 'k': case 'K': n <<= 10; break;
+  case 'm': case 'M': n <<= 20; break;
+  case 'g': case 'G': n <<= 30; break;
+  }
+  return n;
+}
+
+int main(int argc, char **argv)
 {
   short target, source[18] = {
     1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18
   };
+  size_t maxsize = argc > 1 ? parsesize(argv[1]) : 64UL << 20;
+  size_t size, reps, r, m;
+  char *src, *dst;
+  double t;
 
   emitdata(&target, source, 18);
   unrolled(&target, source, 18);
+
+  if (maxsize < MINSIZE) maxsize = MINSIZE;
+  src = malloc(maxsize + 64);
+  dst = malloc(maxsize + 64);
+  if (!src || !dst) { perror("duff"); return 1; }
+  src += 64 - (size_t) src % 64;  /* align to 64 (a cache line) */
+  dst += 64 - (size_t) dst % 64;
+  memset(src, 1, maxsize);
+  memset(dst, 2, maxsize);  /* no page faults in the timing */
+
+  printf("%10s", "bytes");
+  for (m = 0; m < NMETHODS; m++) printf(" %8s", methods[m].name);
+  printf("   (GB/s)\n");
+
+  for (size = MINSIZE; size <= maxsize; size *= 4) {
+    reps = WORK / size ? WORK / size : 1;
+    printf("%10lu", (unsigned long) size);
+    for (m = 0; m < NMETHODS; m++) {
+      methods[m].copy(dst, src, size);  /* warm up */
+      t = now();
+      for (r = 0; r < reps; r++) {
+        methods[m].copy(dst, src, size);
+        __asm__ __volatile__("" : : "r" (dst) : "memory");  /* keep the copy */
+      }
+      t = now() - t;
+      printf(" %8.2f", (double) size * reps / t / 1e9);
+      fflush(stdout);
+    }
+    printf("\n");
+    if (size > maxsize / 4) break;
+  }
   return 0;
 }
-
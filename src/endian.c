@@ -1,12 +1,18 @@
 #include "myutils.h"
+#include "byteorder.h"
 
-/* Assumes sizeof(long) > sizeof(char) */
+/* Known at compile time on most systems (see byteorder.h);
+ * otherwise assumes sizeof(long) > sizeof(char) */
 
 int getendian(void)
 {
+#if ENDIAN_NATIVE
+  return ENDIAN_NATIVE;
+#else
   long value = 1;
   if (sizeof(long) <= sizeof(char)) return 0;
   return *((char *) &value) == 1 ? ENDIAN_LITTLE : ENDIAN_BIG;
+#endif
 }
 
 #ifdef DEMO
@@ -18,6 +24,7 @@ int main(void)
   	case ENDIAN_BIG:    puts("endian: big");    break;
   	default:            puts("endian: error");  break;
   }
+  puts(ENDIAN_NATIVE ? "known at compile time" : "detected at run time");
   return 0;
 }
 #endif
@@ -0,0 +1,71 @@
+#include "myutils.h"
+
+#include <string.h>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+/* Copy with dispatch by size (see bin/duff for the measurements)
+ *
+ * Below NTMIN bytes, nothing beats the C library's memcpy, which
+ * already picks unrolled vector loads and stores (or REP MOVSB) by
+ * size and CPU; Duff's device and other unrolled scalar loops are
+ * much slower. Above NTMIN, the destination would not fit in the
+ * cache anyway, so we copy with non-temporal (streaming) stores,
+ * which write straight to memory: they do not evict the rest of the
+ * cache, and do not first read each destination line into it. The
+ * stores need an aligned destination, so memcpy does the first few
+ * bytes up to alignment, and the tail.
+ */
+
+#define NTMIN (8UL << 20)  /* bytes: about the size of a last level cache */
+
+/** Copy n bytes from src to dst (which must not overlap);
+ *  return dst, like memcpy */
+void *
+fastcopy(void *dst, const void *src, size_t n)
+{
+#if defined(__SSE2__)
+  unsigned char *d = (unsigned char *) dst;
+  const unsigned char *s = (const unsigned char *) src;
+  size_t head;
+
+  if (n < NTMIN) return memcpy(dst, src, n);
+
+  head = (size_t) -(uintptr_t) d & 31;  /* to 32 byte alignment */
+  memcpy(d, s, head);
+  d += head, s += head, n -= head;
+
+#if defined(__AVX__)
+  for (; n >= 128; n -= 128, d += 128, s += 128) {
+    __m256i v0 = _mm256_loadu_si256((const __m256i *) s);
+    __m256i v1 = _mm256_loadu_si256((const __m256i *) (s + 32));
+    __m256i v2 = _mm256_loadu_si256((const __m256i *) (s + 64));
+    __m256i v3 = _mm256_loadu_si256((const __m256i *) (s + 96));
+    _mm256_stream_si256((__m256i *) d, v0);
+    _mm256_stream_si256((__m256i *) (d + 32), v1);
+    _mm256_stream_si256((__m256i *) (d + 64), v2);
+    _mm256_stream_si256((__m256i *) (d + 96), v3);
+  }
+#else
+  for (; n >= 64; n -= 64, d += 64, s += 64) {
+    __m128i v0 = _mm_loadu_si128((const __m128i *) s);
+    __m128i v1 = _mm_loadu_si128((const __m128i *) (s + 16));
+    __m128i v2 = _mm_loadu_si128((const __m128i *) (s + 32));
+    __m128i v3 = _mm_loadu_si128((const __m128i *) (s + 48));
+    _mm_stream_si128((__m128i *) d, v0);
+    _mm_stream_si128((__m128i *) (d + 16), v1);
+    _mm_stream_si128((__m128i *) (d + 32), v2);
+    _mm_stream_si128((__m128i *) (d + 48), v3);
+  }
+#endif
+  _mm_sfence(); /* order the streaming stores before what follows */
+  memcpy(d, s, n);
+  return dst;
+#else
+  return memcpy(dst, src, n);
+#endif
+}
@@ -18,7 +18,7 @@ format(char *buf, size_t size, const char *fmt, ...)
   return r;
 }
 
-#define shipout(c) do { if (!buf) ++i; \
+#define shipout(c) do { if (!buf) (void) (c), ++i; \
   else if (i < size) buf[i++] = (c); \
   else (void) (c); } while (0)
 
@@ -46,12 +46,12 @@ formatv(char *buf, size_t size, const char *fmt, va_list ap)
         for (j=0; j<k; j++) shipout(num[j]);
         break;
       case 'u': /* unsigned decimal */
-        u = va_arg(ap, int);
+        u = va_arg(ap, unsigned);
         k = printu(num, u);
         for (j=0; j<k; j++) shipout(num[j]);
         break;
       case 'x': /* unsigned hex */
-        u = va_arg(ap, int);
+        u = va_arg(ap, unsigned);
         k = printx(num, u);
         for (j=0; j<k; j++) shipout(num[j]);
         break;
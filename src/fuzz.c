@@ -0,0 +1,675 @@
+/* Fuzz targets, with drivers for libFuzzer, AFL, and random inputs
+ *
+ * Each target takes the bytes of one input and returns 0, or -1
+ * (after a message on stderr) if the code under test disagrees with
+ * its reference. The fast paths of this library (SSE2/SSSE3/AVX2
+ * blocks, SWAR digit scanning, lookup tables, the pattern trie)
+ * are compiled in or out by the build flags; the references are
+ * plain byte loops written here, or the older scalar functions
+ * (scanwhile for scanset_while, scanpat for patset, the reader
+ * based iniconf_sz for iniconf_mem). So build the targets with the
+ * flags used in production, e.g. -O2 -mavx2, and with sanitizers:
+ * the copies of the input are allocated to size, so that
+ * AddressSanitizer sees any read beyond the input.
+ *
+ * Drivers (see doc/fuzz.md):
+ *  - libFuzzer: build with -DLIBFUZZER -fsanitize=fuzzer,address;
+ *    the target is $FUZZ_TARGET, or else chosen by the first byte
+ *  - AFL, and replaying crashes: bin/fuzz target [file...] (or stdin)
+ *  - no fuzzer at hand: bin/fuzz -n count [-s seed] [target...]
+ *    runs the targets on random inputs made from their dictionaries
+ */
+
+#include "fuzz.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "byteorder.h"
+#include "iniconf.h"
+#include "print.h"
+#include "rand.h"
+#include "scan.h"
+#include "strbuf.h"
+#include "utf8.h"
+#include "varint.h"
+
+#define CHECK(cond) \
+  do { if (!(cond)) return mismatch(__func__, #cond, __LINE__); } while (0)
+
+static int
+mismatch(const char *func, const char *what, int line)
+{
+  fprintf(stderr, "%s: mismatch at line %d: %s\n", func, line, what);
+  return -1;
+}
+
+static void *
+xmalloc(size_t size)
+{
+  void *p = malloc(size ? size : 1);
+  if (!p) { perror("fuzz"); abort(); }
+  return p;
+}
+
+static char *
+copyz(const unsigned char *data, size_t size, size_t pad)
+{ /* \0 terminated copy, padded with \0 to a multiple of pad (if not 0) */
+  size_t n = pad ? (size + pad) / pad * pad : size + 1;
+  char *z = xmalloc(n);
+  if (size) memcpy(z, data, size);
+  memset(z + size, 0, n - size);
+  return z;
+}
+
+static unsigned char *
+copy(const void *data, size_t size)
+{ /* copy of exactly size bytes (one zero byte if size is 0) */
+  unsigned char *p = xmalloc(size);
+  if (size) memcpy(p, data, size);
+  else *p = 0;
+  return p;
+}
+
+/* iniconf_mem (with SSE2 findany), iniconf_batch and iniconf_par
+ * must all report the same entries as the reader based iniconf_sz */
+
+static void
+addentry(strbuf *sp, iniconf_view sect, iniconf_view name, iniconf_view value, size_t lineno)
+{
+  sbaddb(sp, sect.ptr, sect.len);
+  sbaddc(sp, '\0');
+  sbaddb(sp, name.ptr, name.len);
+  sbaddc(sp, '\0');
+  sbaddb(sp, value.ptr, value.len);
+  sbaddf(sp, "@%lu\n", (unsigned long) lineno);
+}
+
+static int
+szhandler(const char *section, const char *name, const char *value, size_t lineno, void *userdata)
+{
+  iniconf_view s, n, v;
+  s.ptr = section, s.len = strlen(section);
+  n.ptr = name, n.len = strlen(name);
+  v.ptr = value, v.len = strlen(value);
+  addentry((strbuf *) userdata, s, n, v, lineno);
+  return 0;
+}
+
+static int
+viewhandler(iniconf_view section, iniconf_view name, iniconf_view value, size_t lineno, void *userdata)
+{
+  addentry((strbuf *) userdata, section, name, value, lineno);
+  return 0;
+}
+
+static int
+batchhandler(const iniconf_entry entries[], size_t n, void *userdata)
+{
+  size_t i;
+  for (i = 0; i < n; i++)
+    addentry((strbuf *) userdata, entries[i].section, entries[i].name,
+             entries[i].value, entries[i].lineno);
+  return 0;
+}
+
+static int
+sbsame(strbuf *sp, strbuf *sq)
+{
+  return sblen(sp) == sblen(sq) && !memcmp(sbptr(sp), sbptr(sq), sblen(sp));
+}
+
+int
+fuzz_iniconf(const unsigned char *data, size_t size)
+{
+  strbuf ref = {0}, mem = {0}, batch = {0}, par = {0};
+  char *z = copyz(data, size, 0);
+  size_t len = strlen(z);
+  unsigned char *x = copy(z, len); /* not terminated */
+  int r0, r1, r2, r3, same;
+
+  r0 = iniconf_sz(z, szhandler, &ref);
+  r1 = iniconf_mem((char *) x, len, viewhandler, &mem);
+  r2 = iniconf_batch((char *) x, len, 1 + size % 5, batchhandler, &batch);
+  r3 = iniconf_par((char *) x, len, 2, 0, viewhandler, &par);
+  same = sbsame(&ref, &mem) && sbsame(&mem, &batch) && sbsame(&mem, &par);
+
+  sbfree(&ref), sbfree(&mem), sbfree(&batch), sbfree(&par);
+  free(x), free(z);
+  CHECK(r0 == 0 && r1 == 0 && r2 == 0 && r3 == 0);
+  CHECK(same);
+  return 0;
+}
+
+/* UTF8_GET (bounded by end) and utf8len against utf8get,
+ * and utf8put round trips */
+
+int
+fuzz_utf8(const unsigned char *data, size_t size)
+{
+  char *z = copyz(data, size, 0), buf[5];
+  size_t len = strlen(z), cut = len ? size % (len + 1) : 0, n, m, k;
+  const char *x = (const char *) copy(z, len); /* not terminated */
+  const char *p, *q, *end = x + len;
+  int c, d, ok = 1;
+
+  for (p = z, q = x, n = 0; ok && q < end; n++) {
+    p += utf8get(p, &c);
+    UTF8_GET(d, q, end);
+    ok = c == d && p - z == q - x;
+    if (ok && c < 0x110000 && c != 0xFFFD) {
+      k = utf8put(c, buf);
+      buf[k] = 0;
+      ok = utf8get(buf, &d) == k && d == c;
+    }
+  }
+  for (q = x, end = x + cut, m = 0; q < end; m++)
+    UTF8_GET(d, q, end);
+
+  ok = ok && utf8len(x, len) == n && utf8len(z, (size_t) -1) == n;
+  ok = ok && utf8len(x, cut) == m;
+  free((void *) x), free(z);
+  CHECK(ok);
+  return 0;
+}
+
+/* patset (a trie) against scanpat: the first line of the input is
+ * the string, the lines that follow are the patterns */
+
+#define MAXPATS 8
+
+int
+fuzz_scanpat(const unsigned char *data, size_t size)
+{
+  struct patset ps = {0};
+  char *z = copyz(data, size, 0), *pats[MAXPATS], *p;
+  int n[MAXPATS], counts[MAXPATS];
+  int i, npats = 0, matched = 0, r, ok = 1;
+
+  for (p = z; npats < MAXPATS && (p = strchr(p, '\n')); ) {
+    *p++ = '\0';
+    pats[npats++] = p;
+  }
+  if (npats > 0 && (p = strchr(pats[npats-1], '\n'))) *p = '\0';
+
+  for (i = 0; i < npats; i++) {
+    n[i] = scanpat(z, pats[i]);
+    ok = ok && 0 <= n[i] && (size_t) n[i] <= strlen(z);
+    if (n[i] > 0) matched++;
+    ok = ok && patset_add(&ps, pats[i]) == i;
+  }
+  r = patset_match(&ps, z, counts);
+  ok = ok && r == matched;
+  for (i = 0; i < npats; i++)
+    ok = ok && counts[i] == n[i];
+
+  patset_free(&ps);
+  free(z);
+  CHECK(ok);
+  return 0;
+}
+
+/* scandate, scantime, scanzone: print what was scanned
+ * and scan it again */
+
+int
+fuzz_datetime(const unsigned char *data, size_t size)
+{
+  char *z = copyz(data, size, 0), buf[64], *p;
+  size_t len = strlen(z);
+  struct tm tm, tm2;
+  int n, n2, off, off2, ok = 1;
+
+  memset(&tm, 0, sizeof tm), memset(&tm2, 0, sizeof tm2);
+  if ((n = scandate(z, &tm)) > 0) {
+    ok = ok && (size_t) n <= len;
+    format(buf, sizeof buf, "%d-%d-%d", tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday);
+    n2 = scandate(buf, &tm2);
+    ok = ok && (size_t) n2 == strlen(buf) && tm2.tm_year == tm.tm_year &&
+         tm2.tm_mon == tm.tm_mon && tm2.tm_mday == tm.tm_mday;
+  }
+  if ((n = scantime(z, &tm)) > 0) {
+    ok = ok && (size_t) n <= len;
+    p = buf;
+    p += printu(p, (unsigned) tm.tm_hour), *p++ = ':';
+    p += printu(p, (unsigned) tm.tm_min), *p++ = ':';
+    p += printu(p, (unsigned) tm.tm_sec), *p = '\0';
+    n2 = scantime(buf, &tm2);
+    ok = ok && n2 == p - buf && tm2.tm_hour == tm.tm_hour &&
+         tm2.tm_min == tm.tm_min && tm2.tm_sec == tm.tm_sec;
+  }
+  if ((n = scanzone(z, &off)) > 0) {
+    ok = ok && (size_t) n <= len;
+    p = buf;
+    *p++ = off < 0 ? '-' : '+';
+    p += print0u(p, (unsigned) abs(off) / 60, 2), *p++ = ':';
+    p += print0u(p, (unsigned) abs(off) % 60, 2), *p = '\0';
+    n2 = scanzone(buf, &off2);
+    ok = ok && n2 == p - buf && off2 == off;
+  }
+
+  free(z);
+  CHECK(ok);
+  return 0;
+}
+
+/* scanip4op: print what was scanned and scan it again */
+
+int
+fuzz_ip4(const unsigned char *data, size_t size)
+{
+  char *z = copyz(data, size, 0), buf[64];
+  unsigned char ip[4], ip2[4];
+  unsigned port, port2;
+  int n, n2, ok = 1;
+
+  if ((n = scanip4op(z, ip, &port)) > 0) {
+    ok = (size_t) n <= strlen(z) && port <= 65535;
+    ok = ok && scanip4(z, ip2) > 0 && !memcmp(ip, ip2, 4);
+    format(buf, sizeof buf, "%u.%u.%u.%u:%u", ip[0], ip[1], ip[2], ip[3], port);
+    n2 = scanip4op(buf, ip2, &port2);
+    ok = ok && (size_t) n2 == strlen(buf) && !memcmp(ip, ip2, 4) && port2 == port;
+  }
+  n2 = scanip4op(z, ip2, 0);
+  ok = ok && n2 == scanip4(z, ip);
+
+  free(z);
+  CHECK(ok);
+  return 0;
+}
+
+/* formatv against snprintf: the input is the format string, made
+ * safe by changing each conversion to consume the next argument of
+ * the list below (ints and strings alternate), and other % to %%;
+ * formatv prints hex digits in upper case, like printx */
+
+#define MAXFMT 512
+
+int
+fuzz_format(const unsigned char *data, size_t size)
+{
+  static const char convs[] = "sducx";
+  char *fmt = copyz(data, size < MAXFMT ? size : MAXFMT, 0), *rfmt, *p;
+  char buf[MAXFMT*8], ref[MAXFMT*8], small[16];
+  size_t n, m = size % sizeof small;
+  int k = 0, r;
+
+  for (p = fmt; (p = strchr(p, '%')); p++) {
+    if (p[1] == '\0' || k == 8) *p = '_';
+    else if (!strchr(convs, p[1])) *++p = '%';
+    else if (k++ % 2) *++p = 's';
+    else if (*++p == 's') *p = 'd';
+  }
+  rfmt = copyz((unsigned char *) fmt, strlen(fmt), 0);
+  for (p = rfmt; (p = strchr(p, '%')); p += 2)
+    if (p[1] == 'x') p[1] = 'X';
+
+#define ARGS -1, "", -2147483647 - 1, "abc", 0, "%s", 'x', "\t\n"
+  n = format(buf, sizeof buf, fmt, ARGS);
+  r = snprintf(ref, sizeof ref, rfmt, ARGS);
+  k = format(0, 0, fmt, ARGS) == n &&
+      format(small, m, fmt, ARGS) == (n < m ? n : m) && !memcmp(small, ref, n < m ? n : m);
+#undef ARGS
+
+  free(rfmt), free(fmt);
+  CHECK(r >= 0 && n == (size_t) r && !memcmp(buf, ref, n + 1));
+  CHECK(k);
+  return 0;
+}
+
+/* scanset_while/until (SIMD) against scanwhile/scanuntil: the first
+ * byte of the input is the size of the set that follows */
+
+int
+fuzz_scanset(const unsigned char *data, size_t size)
+{
+  size_t k;
+  char *set, *s;
+  charset cs;
+  int i, ok = 1;
+
+  if (size == 0) return 0;
+  k = data[0] % size;
+  set = copyz(data + 1, k, 0);
+  s = copyz(data + 1 + k, size - 1 - k, 16);
+  charset_init(&cs, set);
+  for (i = 0; i < 16 && s[i]; i++) { /* all alignments */
+    ok = ok && scanset_while(s + i, &cs) == scanwhile(s + i, set);
+    ok = ok && scanset_until(s + i, &cs) == scanuntil(s + i, set);
+  }
+
+  free(s), free(set);
+  CHECK(ok);
+  return 0;
+}
+
+/* hexdecode and hexencode (SIMD) against byte loops */
+
+static int
+hexval(int c)
+{
+  if ('0' <= c && c <= '9') return c - '0';
+  if ('a' <= c && c <= 'f') return c - 'a' + 10;
+  if ('A' <= c && c <= 'F') return c - 'A' + 10;
+  return -1;
+}
+
+static int
+checkdecode(const char *s, size_t n, unsigned char *out)
+{
+  size_t i, r = hexdecode(out, s, n);
+  for (i = 0; i < n && hexval(s[2*i]) >= 0 && hexval(s[2*i+1]) >= 0; i++)
+    if (out[i] != (hexval(s[2*i]) << 4 | hexval(s[2*i+1]))) return 0;
+  return r == 2*i;
+}
+
+int
+fuzz_hex(const unsigned char *data, size_t size)
+{
+  static const char digits[] = "0123456789abcdef";
+  unsigned char *x = copy(data, size), *out = xmalloc(size/2 + 64);
+  char *s = xmalloc(2*size), *z = copyz(data, size, 0);
+  size_t i;
+  int ok;
+
+  ok = checkdecode((char *) x, size/2, out);
+  ok = ok && (size == 0 || checkdecode((char *) x + 1, (size-1)/2, out));
+  /* a shorter string: stops at the \0, must not load beyond it */
+  ok = ok && checkdecode(z, strlen(z)/2 + 1 + size % 64, out);
+
+  ok = ok && hexencode(s, x, size) == 2*size;
+  for (i = 0; ok && i < size; i++)
+    ok = s[2*i] == digits[x[i] >> 4] && s[2*i+1] == digits[x[i] & 15];
+
+  free(z), free(s), free(out), free(x);
+  CHECK(ok);
+  return 0;
+}
+
+/* scanuint64 (SWAR) against a digit loop, also across a page end */
+
+static int
+checkuint64(const char *s)
+{
+  uint64_t v = 0, w = 0;
+  int n = 0, r;
+
+  while ('0' <= s[n] && s[n] <= '9') {
+    if (v > (UINT64_MAX - (s[n] - '0')) / 10) { n = 0; break; } /* overflow */
+    v = 10 * v + (s[n++] - '0');
+  }
+  r = scanuint64(s, &w);
+  return r == n && (n == 0 || w == v);
+}
+
+int
+fuzz_scanuint64(const unsigned char *data, size_t size)
+{
+  enum { PAGE = 4096 };
+  char *z = copyz(data, size, 16), *pages, *end, *s;
+  size_t len = strlen(z), i;
+  int ok = 1;
+
+  for (i = 0; i < 8 && i <= len; i++)
+    ok = ok && checkuint64(z + i);
+
+  /* end the string at each of the 16 bytes before a page end */
+  if (len < PAGE/2 && (pages = malloc(3 * PAGE))) {
+    end = pages + 2*PAGE - (uintptr_t) (pages + 2*PAGE) % PAGE;
+    memset(pages, 0, 3 * PAGE);
+    for (i = 0; i < 16; i++) {
+      s = end - len - 1 - i;
+      memcpy(s, z, len + 1);
+      ok = ok && checkuint64(s);
+    }
+    free(pages);
+  }
+
+  free(z);
+  CHECK(ok);
+  return 0;
+}
+
+/* varint_get and svb_decode against byte loops, and round trips */
+
+static size_t
+refsvb(uint32_t out[], const unsigned char *buf, size_t len, size_t n)
+{ /* the Stream VByte format, spelled out */
+  size_t i, ctl = (n+3)/4, at = ctl;
+  unsigned k, l;
+
+  if (len < ctl) return 0;
+  for (i = 0; i < n; i++) {
+    l = ((buf[i/4] >> 2*(i%4)) & 3) + 1;
+    if (len - at < l) return 0;
+    for (out[i] = 0, k = 0; k < l; k++) out[i] |= (uint32_t) buf[at+k] << 8*k;
+    at += l;
+  }
+  return at;
+}
+
+int
+fuzz_varint(const unsigned char *data, size_t size)
+{
+  unsigned char *x = copy(data, size), enc[SVB_MAX(256)];
+  size_t n = size ? data[0] : 0, r, i;
+  uint32_t out[256], ref[256];
+  uint64_t v = 0, w = 0;
+  int ok = 1;
+
+  for (i = 0; i < size && i < VARINT_MAX; i++) { /* reference varint */
+    w |= (uint64_t) (x[i] & 0x7F) << 7*i;
+    if (x[i] < 0x80) break;
+  }
+  if (i == size || i == VARINT_MAX || (i == VARINT_MAX-1 && x[i] > 1)) i = 0;
+  else i++;
+  r = varint_get(x, size, &v);
+  ok = r == i && (r == 0 || v == w);
+  if (r > 0) {
+    ok = ok && varint_len(v) <= r && varint_put(enc, v) == varint_len(v);
+    ok = ok && varint_get(enc, varint_len(v), &w) == varint_len(v) && w == v;
+  }
+
+  if (size > 0) {
+    r = svb_decode(out, x + 1, size - 1, n);
+    ok = ok && r == refsvb(ref, x + 1, size - 1, n);
+    ok = ok && (r == 0 || !memcmp(out, ref, n * sizeof out[0]));
+    if (r > 0) {
+      r = svb_encode(enc, out, n);
+      ok = ok && svb_decode(ref, enc, r, n) == r && !memcmp(out, ref, n * sizeof out[0]);
+    }
+  }
+
+  free(x);
+  CHECK(ok);
+  return 0;
+}
+
+/* bswap_array16/32/64 (SIMD) against bswap16/32/64 */
+
+int
+fuzz_bswap(const unsigned char *data, size_t size)
+{
+  unsigned char *x = copy(data, size), *y = xmalloc(size + 1);
+  size_t i, n;
+  uint16_t a16, b16;
+  uint32_t a32, b32;
+  uint64_t a64, b64;
+  int ok = 1;
+
+  n = size / 2; /* unaligned dst */
+  bswap_array16(y + 1, x, n);
+  for (i = 0; i < n; i++) {
+    memcpy(&a16, x + 2*i, 2), memcpy(&b16, y + 1 + 2*i, 2);
+    ok = ok && b16 == bswap16(a16);
+  }
+  n = size / 4;
+  bswap_array32(y, x, n);
+  for (i = 0; i < n; i++) {
+    memcpy(&a32, x + 4*i, 4), memcpy(&b32, y + 4*i, 4);
+    ok = ok && b32 == bswap32(a32);
+  }
+  n = size / 8;
+  bswap_array64(y, x, n);
+  for (i = 0; i < n; i++) {
+    memcpy(&a64, x + 8*i, 8), memcpy(&b64, y + 8*i, 8);
+    ok = ok && b64 == bswap64(a64);
+  }
+
+  free(y), free(x);
+  CHECK(ok);
+  return 0;
+}
+
+const struct fuzz_entry fuzz_targets[] = {
+  { "iniconf", fuzz_iniconf, "[]=;#\\\n\r \t\"ab" },
+  { "utf8", fuzz_utf8, "a\x7f\x80\xbf\xc0\xc2\xdf\xe0\xed\xef\xf0\xf4\xf7\xf8\xfe\xff" },
+  { "scanpat", fuzz_scanpat, "\n\n\n*  \tab" },
+  { "datetime", fuzz_datetime, "0123456789-:+Z" },
+  { "ip4", fuzz_ip4, "0123456789.:% \t" },
+  { "format", fuzz_format, "%%%sducxa" },
+  { "scanset", fuzz_scanset, "\x03\x10" "abcxyz" },
+  { "hex", fuzz_hex, "0123456789abcdefABCDEFgG" },
+  { "scanuint64", fuzz_scanuint64, "0123456789999999" },
+  { "varint", fuzz_varint, "\x00\x01\x7f\x80\xff" },
+  { "bswap", fuzz_bswap, "" },
+  { 0, 0, 0 }
+};
+
+/** Look up a target by name, return null if there is none */
+const struct fuzz_entry *
+fuzz_find(const char *name)
+{
+  const struct fuzz_entry *fp;
+  for (fp = fuzz_targets; fp->name; fp++)
+    if (!strcmp(fp->name, name)) return fp;
+  return 0;
+}
+
+/** Make a random input of up to max bytes into buf, mostly
+ *  from the bytes in dict (if not empty); return its size */
+size_t
+fuzz_input(unsigned char *buf, size_t max, const char *dict, uint64_t *seed)
+{
+  size_t n = (size_t) (splitmix64(seed) % (max + 1)), i, k = strlen(dict);
+  uint64_t r;
+
+  n = (size_t) (splitmix64(seed) % (n + 1)); /* more short ones */
+  for (i = 0; i < n; i++) {
+    r = splitmix64(seed);
+    buf[i] = k && r % 4 ? (unsigned char) dict[(r >> 8) % k] : (unsigned char) (r >> 32);
+  }
+  return n;
+}
+
+#ifdef LIBFUZZER
+int LLVMFuzzerTestOneInput(const unsigned char *data, size_t size);
+
+int
+LLVMFuzzerTestOneInput(const unsigned char *data, size_t size)
+{
+  static const struct fuzz_entry *target;
+  static size_t ntargets;
+  const struct fuzz_entry *fp = target;
+
+  if (!ntargets) {
+    const char *name = getenv("FUZZ_TARGET");
+    while (fuzz_targets[ntargets].name) ntargets++;
+    if (name && !(target = fuzz_find(name))) {
+      fprintf(stderr, "fuzz: no target %s\n", name);
+      exit(2);
+    }
+    fp = target;
+  }
+  if (!fp) { /* the first byte chooses */
+    if (size == 0) return 0;
+    fp = &fuzz_targets[data[0] % ntargets];
+    data++, size--;
+  }
+  if (fp->run(data, size) != 0) abort();
+  return 0;
+}
+#endif
+
+#ifdef DEMO
+/* Driver for AFL, for replaying inputs, and for random inputs */
+
+#define MAXINPUT 4096
+
+static int
+runfile(const struct fuzz_entry *fp, const char *fn)
+{
+  strbuf sb = {0};
+  FILE *f = fn ? fopen(fn, "rb") : stdin;
+  char buf[4096];
+  size_t n;
+  int r;
+
+  if (!f) { perror(fn); return -1; }
+  while ((n = fread(buf, 1, sizeof buf, f)) > 0) sbaddb(&sb, buf, n);
+  if (fn) fclose(f);
+  r = fp->run((const unsigned char *) sbptr(&sb), sblen(&sb));
+  sbfree(&sb);
+  return r;
+}
+
+static int
+runrandom(const struct fuzz_entry *fp, long count, uint64_t seed)
+{
+  static unsigned char buf[MAXINPUT];
+  char fn[64];
+  FILE *f;
+  size_t n;
+  long i;
+
+  for (i = 0; i < count; i++) {
+    n = fuzz_input(buf, i < count/2 ? 64 : MAXINPUT, fp->dict, &seed);
+    if (fp->run(buf, n) == 0) continue;
+    format(fn, sizeof fn, "fuzz-%s.fail", fp->name);
+    if ((f = fopen(fn, "wb"))) fwrite(buf, 1, n, f), fclose(f);
+    fprintf(stderr, "%s: failed on input %ld, saved to %s\n", fp->name, i, fn);
+    return -1;
+  }
+  printf("%-12s %ld inputs ok\n", fp->name, count);
+  return 0;
+}
+
+int
+main(int argc, char **argv)
+{
+  const struct fuzz_entry *fp;
+  uint64_t seed = 1;
+  long count = 0;
+  int i = 1, fails = 0;
+
+  for (; i < argc && argv[i][0] == '-' && argv[i][1]; i++) {
+    if (!strcmp(argv[i], "-n") && i+1 < argc) count = atol(argv[++i]);
+    else if (!strcmp(argv[i], "-s") && i+1 < argc) seed = strtoull(argv[++i], 0, 10);
+    else break;
+  }
+  if ((count <= 0 && i >= argc) || (i < argc && argv[i][0] == '-')) {
+    fprintf(stderr, "Usage: %s target [file...]  (stdin if no file)\n"
+                    "       %s -n count [-s seed] [target...]\nTargets:", argv[0], argv[0]);
+    for (fp = fuzz_targets; fp->name; fp++) fprintf(stderr, " %s", fp->name);
+    fprintf(stderr, "\n");
+    return 2;
+  }
+
+  if (count > 0) {
+    if (i == argc)
+      for (fp = fuzz_targets; fp->name; fp++) fails += runrandom(fp, count, seed) != 0;
+    for (; i < argc; i++) {
+      if (!(fp = fuzz_find(argv[i]))) { fprintf(stderr, "no target %s\n", argv[i]); return 2; }
+      fails += runrandom(fp, count, seed) != 0;
+    }
+    return fails ? 1 : 0;
+  }
+
+  if (!(fp = fuzz_find(argv[i]))) { fprintf(stderr, "no target %s\n", argv[i]); return 2; }
+  if (++i == argc) fails += runfile(fp, 0) != 0;
+  for (; i < argc; i++) fails += runfile(fp, argv[i]) != 0;
+  if (fails) abort(); /* for AFL */
+  return 0;
+}
+#endif
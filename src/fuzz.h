@@ -0,0 +1,40 @@
+#ifndef FUZZ_H
+#define FUZZ_H
+
+/* Fuzz targets for the scanners and parsers, for libFuzzer, AFL,
+ * or the random driver in fuzz.c (see doc/fuzz.md). Each target
+ * takes arbitrary bytes, checks the optimized (SIMD, SWAR, table)
+ * implementation against a simple reference, and the parsers for
+ * round trips; it returns 0, or -1 after reporting a mismatch
+ * on stderr. Crashes are left to the sanitizers.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef int (*fuzz_target)(const unsigned char *data, size_t size);
+
+struct fuzz_entry {
+  const char *name;
+  fuzz_target run;
+  const char *dict;  /* bytes that make interesting inputs */
+};
+
+extern const struct fuzz_entry fuzz_targets[]; /* ends with name null */
+
+const struct fuzz_entry *fuzz_find(const char *name);
+size_t fuzz_input(unsigned char *buf, size_t max, const char *dict, uint64_t *seed);
+
+int fuzz_iniconf(const unsigned char *data, size_t size);
+int fuzz_utf8(const unsigned char *data, size_t size);
+int fuzz_scanpat(const unsigned char *data, size_t size);
+int fuzz_datetime(const unsigned char *data, size_t size);
+int fuzz_ip4(const unsigned char *data, size_t size);
+int fuzz_format(const unsigned char *data, size_t size);
+int fuzz_scanset(const unsigned char *data, size_t size);
+int fuzz_hex(const unsigned char *data, size_t size);
+int fuzz_scanuint64(const unsigned char *data, size_t size);
+int fuzz_varint(const unsigned char *data, size_t size);
+int fuzz_bswap(const unsigned char *data, size_t size);
+
+#endif
@@ -0,0 +1,52 @@
+/* Unit tests: the fuzz targets (fuzz.c) on a few seeds and random inputs */
+
+#include "test.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#include "fuzz.h"
+
+#define RANDOM 2000  /* random inputs per target; use bin/fuzz for more */
+
+void
+fuzz_test(int *pnumpass, int *pnumfail)
+{
+  int numpass = 0;
+  int numfail = 0;
+
+  static const char *seeds[] = {
+    "", "[s]\na = 1\r\nb=two\\\n lines ; c\n[t \\\n u]\n", "\xef\xbb\xbf" "x=\"q\"",
+    "Gr\xc3\xbc\xc3\x9f" "e \xe2\x82\xac \xf0\x9f\x98\x80 \xed\xa0\x80 \xc0\x80 \xf8\x88\x80\x80\x80",
+    "foo: bar.txt\nfoo*\n *:\n f*t\nfoo: *.txt", "2005-07-14", "-5-2-03", "12:34:56",
+    "05:12", "+02:00", "-0530", "Z", "192.168.1.2", "10.1.2.3:4321", "1.2.3.4 % 65536",
+    "%% %c %d %u %x %s %", "%s%s%s%s%s%s%s%s%s%s", "\x05" "abcde" "abcdeabcdeabcdeabcdeabcdeXabc",
+    "00112233445566778899aabbccddeeffAABBCCDDEEFF0011223344556677889", "18446744073709551615",
+    "18446744073709551616", "00000000000000000000000000001", "\x80\x80\x80\x80\x80\x80\x80\x80\x80\x01",
+    "\x08\xff\x00\x01\x02\x03\x04\x05\x06\x07\x08\x09\x0a\x0b\x0c\x0d\x0e\x0f\x10\x11\x12\x13\x14",
+  };
+  static unsigned char buf[1024];
+  const struct fuzz_entry *fp;
+  uint64_t seed = 42;
+  size_t i, n;
+  int fails;
+  char name[64];
+
+  HEADING("Testing fuzz targets");
+
+  for (fp = fuzz_targets; fp->name; fp++) {
+    fails = 0;
+    for (i = 0; i < sizeof seeds / sizeof seeds[0]; i++)
+      fails += fp->run((const unsigned char *) seeds[i], strlen(seeds[i])) != 0;
+    for (i = 0; i < RANDOM; i++) {
+      n = fuzz_input(buf, i < RANDOM/2 ? 64 : sizeof buf, fp->dict, &seed);
+      fails += fp->run(buf, n) != 0;
+    }
+    strcpy(name, "fuzz ");
+    strncat(name, fp->name, sizeof name - 6);
+    TEST(name, fails == 0);
+  }
+
+  *pnumpass += numpass;
+  *pnumfail += numfail;
+}
@@ -0,0 +1,121 @@
+/* required for strnlen */
+#define _POSIX_C_SOURCE 200809L
+
+#include "scan.h"
+
+#include <string.h>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSSE3__)
+#include <tmmintrin.h>
+#endif
+
+/* Value of hex digit c, or a value > 15 if c is not a hex digit */
+static unsigned
+hexval(unsigned char c)
+{
+  unsigned d = (unsigned) c - '0';
+  unsigned a = ((unsigned) c | 0x20) - 'a';
+  if (d < 10) return d;
+  if (a < 6) return a + 10;
+  return 16;
+}
+
+#if defined(__SSSE3__)
+/* Map 16 chars to their digit values; set *ok to a bit mask
+ * where bit i is set if char i is a valid hex digit */
+static __m128i
+hexval16(__m128i c, int *ok)
+{
+  __m128i d = _mm_sub_epi8(c, _mm_set1_epi8('0'));
+  __m128i a = _mm_sub_epi8(_mm_or_si128(c, _mm_set1_epi8(0x20)), _mm_set1_epi8('a'));
+  __m128i dm = _mm_cmpeq_epi8(_mm_min_epu8(d, _mm_set1_epi8(9)), d);
+  __m128i am = _mm_cmpeq_epi8(_mm_min_epu8(a, _mm_set1_epi8(5)), a);
+  a = _mm_add_epi8(a, _mm_set1_epi8(10));
+  *ok = _mm_movemask_epi8(_mm_or_si128(dm, am));
+  return _mm_or_si128(_mm_and_si128(d, dm), _mm_and_si128(a, am));
+}
+#endif
+
+#if defined(__AVX2__)
+static __m256i
+hexval32(__m256i c, int *ok)
+{
+  __m256i d = _mm256_sub_epi8(c, _mm256_set1_epi8('0'));
+  __m256i a = _mm256_sub_epi8(_mm256_or_si256(c, _mm256_set1_epi8(0x20)), _mm256_set1_epi8('a'));
+  __m256i dm = _mm256_cmpeq_epi8(_mm256_min_epu8(d, _mm256_set1_epi8(9)), d);
+  __m256i am = _mm256_cmpeq_epi8(_mm256_min_epu8(a, _mm256_set1_epi8(5)), a);
+  a = _mm256_add_epi8(a, _mm256_set1_epi8(10));
+  *ok = _mm256_movemask_epi8(_mm256_or_si256(dm, am));
+  return _mm256_or_si256(_mm256_and_si256(d, dm), _mm256_and_si256(a, am));
+}
+#endif
+
+/** Scan up to 2n hex digits (0-9 a-f A-F) from s into n bytes at buf;
+ *  stop at the first pair that is not two hex digits; return #chars
+ *  scanned (twice the number of bytes stored into buf).
+ *
+ *  With SSSE3 or AVX2, 32 or 64 chars are validated and converted
+ *  per step; pairs of digit values are combined by PMADDUBSW with
+ *  weights 16 and 1, and packed back into bytes. A block with an
+ *  invalid char is left to the scalar loop at the end, which finds
+ *  the exact place where scanning stops. The blocks are loaded only
+ *  where s is known to be readable, that is, up to its \0 (found by
+ *  strnlen) or 2n chars, so s may be a short string.
+ */
+size_t
+hexdecode(void *buf, const char *s, size_t n)
+{
+  unsigned char *p = (unsigned char *) buf;
+  size_t i = 0;
+#if defined(__SSSE3__)
+  size_t m; /* bytes in the part of s that can be loaded */
+#endif
+
+  if (!s) return 0;
+#if defined(__SSSE3__)
+  m = n >= 16 ? strnlen(s, 2*n) / 2 : 0;
+#endif
+
+#if defined(__AVX2__)
+  {
+    const __m256i weights = _mm256_set1_epi16(0x0110); /* 16, 1 */
+    for (; i + 32 <= m; i += 32) {
+      int ok0, ok1;
+      __m256i v0 = hexval32(_mm256_loadu_si256((const __m256i *) (s + 2*i)), &ok0);
+      __m256i v1 = hexval32(_mm256_loadu_si256((const __m256i *) (s + 2*i + 32)), &ok1);
+      if ((ok0 & ok1) != -1) break;
+      v0 = _mm256_maddubs_epi16(v0, weights);
+      v1 = _mm256_maddubs_epi16(v1, weights);
+      v0 = _mm256_permute4x64_epi64(_mm256_packus_epi16(v0, v1), 0xD8);
+      _mm256_storeu_si256((__m256i *) (p + i), v0);
+    }
+  }
+#endif
+#if defined(__SSSE3__)
+  {
+    const __m128i weights = _mm_set1_epi16(0x0110); /* 16, 1 */
+    for (; i + 16 <= m; i += 16) {
+      int ok0, ok1;
+      __m128i v0 = hexval16(_mm_loadu_si128((const __m128i *) (s + 2*i)), &ok0);
+      __m128i v1 = hexval16(_mm_loadu_si128((const __m128i *) (s + 2*i + 16)), &ok1);
+      if ((ok0 & ok1) != 0xFFFF) break;
+      v0 = _mm_maddubs_epi16(v0, weights);
+      v1 = _mm_maddubs_epi16(v1, weights);
+      _mm_storeu_si128((__m128i *) (p + i), _mm_packus_epi16(v0, v1));
+    }
+  }
+#endif
+
+  for (; i < n; i++) {
+    unsigned hi = hexval((unsigned char) s[2*i]);
+    unsigned lo;
+    if (hi > 15) break;
+    lo = hexval((unsigned char) s[2*i+1]);
+    if (lo > 15) break;
+    p[i] = (unsigned char) (hi << 4 | lo);
+  }
+
+  return 2*i; /* #chars scanned */
+}
@@ -0,0 +1,64 @@
+#include "print.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSSE3__)
+#include <tmmintrin.h>
+#endif
+
+/* With SSSE3, the nibbles of 16 bytes are split into two vectors
+ * and looked up in the 16 entry digit table with one PSHUFB each,
+ * then interleaved back into 32 hex digits; with AVX2 the same
+ * for 32 bytes at a time. Build with -mssse3 or -mavx2 (or with
+ * -march=native) to get these code paths; the loop at the end
+ * does the remaining bytes (all bytes if no SIMD is available).
+ */
+
+size_t /* print n bytes from buf as 2n lowercase hex digits, return #chars */
+hexencode(char *s, const void *buf, size_t n)
+{
+  static const char digits[] = "0123456789abcdef";
+  const unsigned char *p = (const unsigned char *) buf;
+  size_t i = 0;
+
+  if (!s) return 2*n;
+
+#if defined(__AVX2__)
+  {
+    const __m256i lut = _mm256_setr_epi8(
+      '0','1','2','3','4','5','6','7','8','9','a','b','c','d','e','f',
+      '0','1','2','3','4','5','6','7','8','9','a','b','c','d','e','f');
+    const __m256i mask = _mm256_set1_epi8(0x0F);
+    for (; i + 32 <= n; i += 32) {
+      __m256i v = _mm256_loadu_si256((const __m256i *) (p + i));
+      __m256i hi = _mm256_shuffle_epi8(lut, _mm256_and_si256(_mm256_srli_epi16(v, 4), mask));
+      __m256i lo = _mm256_shuffle_epi8(lut, _mm256_and_si256(v, mask));
+      __m256i a = _mm256_unpacklo_epi8(hi, lo); /* bytes 0..7, 16..23 */
+      __m256i b = _mm256_unpackhi_epi8(hi, lo); /* bytes 8..15, 24..31 */
+      _mm256_storeu_si256((__m256i *) (s + 2*i), _mm256_permute2x128_si256(a, b, 0x20));
+      _mm256_storeu_si256((__m256i *) (s + 2*i + 32), _mm256_permute2x128_si256(a, b, 0x31));
+    }
+  }
+#endif
+#if defined(__SSSE3__)
+  {
+    const __m128i lut = _mm_setr_epi8(
+      '0','1','2','3','4','5','6','7','8','9','a','b','c','d','e','f');
+    const __m128i mask = _mm_set1_epi8(0x0F);
+    for (; i + 16 <= n; i += 16) {
+      __m128i v = _mm_loadu_si128((const __m128i *) (p + i));
+      __m128i hi = _mm_shuffle_epi8(lut, _mm_and_si128(_mm_srli_epi16(v, 4), mask));
+      __m128i lo = _mm_shuffle_epi8(lut, _mm_and_si128(v, mask));
+      _mm_storeu_si128((__m128i *) (s + 2*i), _mm_unpacklo_epi8(hi, lo));
+      _mm_storeu_si128((__m128i *) (s + 2*i + 16), _mm_unpackhi_epi8(hi, lo));
+    }
+  }
+#endif
+
+  for (; i < n; i++) {
+    s[2*i] = digits[p[i] >> 4];
+    s[2*i+1] = digits[p[i] & 15];
+  }
+
+  return 2*n;
+}
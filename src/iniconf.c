@@ -1,11 +1,25 @@
+/* required for mmap, fileno */
+#define _POSIX_C_SOURCE 200112L
 
 #include "iniconf.h"
+#include "inifile.h"
 #include "strbuf.h"
 
 #include <assert.h>
 #include <ctype.h>
 #include <errno.h>
+#include <stdint.h>
 #include <stdio.h>
+#include <string.h>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
 typedef struct {
   iniconf_reader reader;
@@ -18,43 +32,190 @@ typedef struct {
 
 static int iniconf(parser_t *pp, iniconf_handler handler, void *userstate);
 
+struct adapter { iniconf_handler handler; void *userdata; strbuf buf; };
+
+static int adapt(iniconf_view sect, iniconf_view name, iniconf_view value,
+                 size_t lineno, void *userdata)
+{ /* call the classic handler with zero-terminated copies */
+  struct adapter *ap = (struct adapter *) userdata;
+  strbuf *sp = &ap->buf;
+  size_t nameofs, valueofs;
+  const char *s;
+
+  sbtrunc(sp, 0);
+  sbaddb(sp, sect.ptr, sect.len);
+  sbaddc(sp, '\0');
+  nameofs = sblen(sp);
+  sbaddb(sp, name.ptr, name.len);
+  sbaddc(sp, '\0');
+  valueofs = sblen(sp);
+  sbaddb(sp, value.ptr, value.len);
+
+  if (sbfailed(sp)) {
+    errno = ENOMEM;
+    return -1;
+  }
+
+  s = sbptr(sp);
+  return ap->handler(s, s+nameofs, s+valueofs, lineno, ap->userdata);
+}
+
 int iniconf_fn(const char *fn, iniconf_handler handler, void *userdata)
 {
+  struct adapter adapter = { 0, 0, {0} };
   int r, saverr;
-  FILE *fp = fopen(fn, "r");
-  if (!fp) return -1;
-  r = iniconf_fp(fp, handler, userdata);
+  if (!handler) return iniconf_map(fn, 0, 0);
+  adapter.handler = handler;
+  adapter.userdata = userdata;
+  r = iniconf_map(fn, adapt, &adapter);
   saverr = errno;
-  fclose(fp);
+  sbfree(&adapter.buf);
   errno = saverr;
   return r;
 }
 
-static int readstream(void *state)
+static int readall(int fd, strbuf *sp)
+{ /* read all of fd into sp, return -1 on error */
+  ssize_t n;
+  do {
+    if (!sbready(sp, 4096)) { errno = ENOMEM; return -1; }
+    n = read(fd, sp->buf + sp->len, sbsize(sp) - sp->len - 1);
+    if (n < 0 && errno == EINTR) continue;
+    if (n < 0) return -1;
+    sp->len += n;
+    sp->buf[sp->len] = '\0';
+  } while (n > 0);
+  return 0;
+}
+
+int inifile_read(struct inifile *fp, int fd, const struct stat *st)
+{ /* map a regular file, read anything else (a pipe, say) */
+  size_t len;
+  void *map;
+
+  memset(fp, 0, sizeof *fp);
+  fp->ptr = "";
+
+  if (st && S_ISREG(st->st_mode) && st->st_size > 0 &&
+      (off_t) (len = (size_t) st->st_size) == st->st_size) {
+    map = mmap(0, len, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (map != MAP_FAILED) {
+      posix_madvise(map, len, POSIX_MADV_SEQUENTIAL);
+      fp->ptr = fp->map = map;
+      fp->len = len;
+      return 0;
+    }
+  }
+
+  if (readall(fd, &fp->buf) < 0) return -1;
+  fp->ptr = sbptr(&fp->buf);
+  fp->len = sblen(&fp->buf);
+  return 0;
+}
+
+void inifile_free(struct inifile *fp)
 {
-  return getc((FILE *) state);
+  int saverr = errno;
+  if (fp->map) munmap(fp->map, fp->len);
+  sbfree(&fp->buf);
+  memset(fp, 0, sizeof *fp);
+  fp->ptr = "";
+  errno = saverr;
 }
 
-int iniconf_fp(FILE *fp, iniconf_handler handler, void *userdata)
+uint64_t inifile_hash(const char *p, size_t n)
 {
-  return iniconf_rf(readstream, fp, handler, userdata);
+  const unsigned char *q = (const unsigned char *) p;
+  uint64_t h = UINT64_C(14695981039346656037);
+  while (n-- > 0) h = (h ^ *q++) * UINT64_C(1099511628211);
+  return h;
 }
 
-struct stringstate { const char *sz; size_t i; };
+struct mapping {
+  int nthreads, flags;              /* for iniconf_par */
+  iniconf_viewhandler handler;
+  size_t batchsize;                 /* for iniconf_batch */
+  iniconf_batchhandler batch;
+  void *userdata;
+};
 
-static int readstring(void *state)
+static int parsebuf(const char *buf, size_t len, const struct mapping *mp)
 {
-  struct stringstate *ss = (struct stringstate *) state;
-  char c = ss->sz[ss->i];
-  if (!c) return EOF;
-  ss->i += 1;
-  return (int) (unsigned char) c;
+  if (mp->batch) return iniconf_batch(buf, len, mp->batchsize, mp->batch, mp->userdata);
+  return iniconf_par(buf, len, mp->nthreads, mp->flags, mp->handler, mp->userdata);
+}
+
+static int mapfile(const char *fn, const struct mapping *mp)
+{ /* parse file fn in memory, as told by mp */
+  struct inifile file;
+  struct stat st;
+  int fd, r, saverr;
+
+  if ((fd = open(fn, O_RDONLY)) < 0) return -1;
+  r = inifile_read(&file, fd, fstat(fd, &st) == 0 ? &st : 0);
+  saverr = errno;
+  close(fd);
+  errno = saverr;
+  if (r < 0) { inifile_free(&file); return -1; }
+
+  r = parsebuf(file.ptr, file.len, mp);
+  inifile_free(&file);
+  return r;
+}
+
+int iniconf_map(const char *fn, iniconf_viewhandler handler, void *userdata)
+{
+  struct mapping m = { 1, 0, 0, 0, 0, 0 };
+  m.handler = handler;
+  m.userdata = userdata;
+  return mapfile(fn, &m);
+}
+
+int iniconf_mappar(const char *fn, int nthreads, int flags,
+                   iniconf_viewhandler handler, void *userdata)
+{
+  struct mapping m = { 0, 0, 0, 0, 0, 0 };
+  m.nthreads = nthreads;
+  m.flags = flags;
+  m.handler = handler;
+  m.userdata = userdata;
+  return mapfile(fn, &m);
+}
+
+int iniconf_mapbatch(const char *fn, size_t batchsize,
+                     iniconf_batchhandler handler, void *userdata)
+{
+  struct mapping m = { 1, 0, 0, 0, 0, 0 };
+  m.batchsize = batchsize;
+  m.batch = handler;
+  m.userdata = userdata;
+  if (!handler) return iniconf_map(fn, 0, 0);
+  return mapfile(fn, &m);
+}
+
+static int readstream(void *state)
+{
+  return getc((FILE *) state);
+}
+
+int iniconf_fp(FILE *fp, iniconf_handler handler, void *userdata)
+{
+  return iniconf_rf(readstream, fp, handler, userdata);
 }
 
 int iniconf_sz(const char *sz, iniconf_handler handler, void *userdata)
 {
-  struct stringstate state = { sz, 0 };
-  return iniconf_rf(readstring, &state, handler, userdata);
+  struct adapter adapter = { 0, 0, {0} };
+  int r, saverr;
+  if (!sz) return 0;
+  if (!handler) return iniconf_mem(sz, strlen(sz), 0, 0);
+  adapter.handler = handler;
+  adapter.userdata = userdata;
+  r = iniconf_mem(sz, strlen(sz), adapt, &adapter);
+  saverr = errno;
+  sbfree(&adapter.buf);
+  errno = saverr;
+  return r;
 }
 
 int iniconf_rf(iniconf_reader rf, void *rfstate, iniconf_handler handler, void *userdata)
@@ -269,3 +430,171 @@ iniconf(parser_t *pp, iniconf_handler handler, void *userdata)
 
   return r;
 }
+
+/* The memory parser: same grammar and results as above, but it
+ * works on the bytes in place, finds the end of each token with
+ * a SIMD search (16 bytes at a time), and passes views into the
+ * buffer to the handler. Only a token with a continuation (a
+ * backslash newline) must be copied, to join its pieces.
+ */
+
+#define ISSPACE(c) ((c) == ' ' || ((c) >= '\t' && (c) <= '\r'))
+
+typedef struct {
+  const char *p;    /* current position */
+  const char *end;  /* end of buffer */
+  size_t lineno;    /* line number at p */
+} cursor_t;
+
+static const char *findany(const char *p, const char *end, int a, int b, int c, int d)
+{ /* find first byte in p..end that is one of a, b, c, d */
+#if defined(__SSE2__)
+  if (end - p >= 16) {
+    const __m128i va = _mm_set1_epi8((char) a);
+    const __m128i vb = _mm_set1_epi8((char) b);
+    const __m128i vc = _mm_set1_epi8((char) c);
+    const __m128i vd = _mm_set1_epi8((char) d);
+    for (; end - p >= 16; p += 16) {
+      __m128i v = _mm_loadu_si128((const __m128i *) p);
+      unsigned m = _mm_movemask_epi8(_mm_or_si128(
+        _mm_or_si128(_mm_cmpeq_epi8(v, va), _mm_cmpeq_epi8(v, vb)),
+        _mm_or_si128(_mm_cmpeq_epi8(v, vc), _mm_cmpeq_epi8(v, vd))));
+      if (m) {
+#if defined(__GNUC__)
+        return p + __builtin_ctz(m);
+#else
+        for (; !(m & 1); m >>= 1) p++;
+        return p;
+#endif
+      }
+    }
+  }
+#endif
+  for (; p < end; p++) {
+    int x = (unsigned char) *p;
+    if (x == a || x == b || x == c || x == d) break;
+  }
+  return p;
+}
+
+static void next_line(cursor_t *cp)
+{ /* step over the newline (LF, CRLF, or CR) at p, if any */
+  if (cp->p >= cp->end) return;
+  if (*cp->p == '\r' && cp->p+1 < cp->end && cp->p[1] == '\n') cp->p++;
+  cp->p++;
+  cp->lineno++;
+}
+
+static void skip_lines(cursor_t *cp)
+{ /* skip white space, counting lines */
+  while (cp->p < cp->end && ISSPACE((unsigned char) *cp->p)) {
+    if (*cp->p == '\n' || *cp->p == '\r') next_line(cp);
+    else cp->p++;
+  }
+}
+
+static int scan_view(cursor_t *cp, int delim, strbuf *sp, iniconf_view *vp, size_t keep)
+{ /* scan text up to delim or newline (see scan_text), return -1 if nomem */
+  const char *start, *q;
+  int copied = 0;
+
+  while (cp->p < cp->end && (*cp->p == ' ' || *cp->p == '\t')) cp->p++;
+
+  for (start = q = cp->p; ; q++) {
+    q = findany(q, cp->end, delim, '\n', '\r', '\\');
+    if (q >= cp->end || *q != '\\') { cp->p = q; break; }
+    if (q+1 >= cp->end) { cp->p = cp->end; break; } /* discard backslash at eof */
+    if (q[1] == '\n' || q[1] == '\r') { /* discard backslash newline */
+      if (!copied) sbtrunc(sp, 0), copied = 1;
+      sbaddb(sp, start, q - start);
+      cp->p = q+1;
+      next_line(cp);
+      start = cp->p;
+      q = start - 1;
+    }
+    /* else: a backslash that stands for itself */
+  }
+
+  if (copied) {
+    sbaddb(sp, start, q - start);
+    if (sbfailed(sp)) { errno = ENOMEM; return -1; }
+    vp->ptr = sbptr(sp);
+    vp->len = sblen(sp);
+  }
+  else {
+    vp->ptr = start;
+    vp->len = q - start;
+  }
+
+  /* trim white space from the right, but keep a prefix of keep */
+  while (vp->len > keep && ISSPACE((unsigned char) vp->ptr[vp->len-1]))
+    vp->len--;
+
+  return 0;
+}
+
+int iniconf_mem(const char *buf, size_t len, iniconf_viewhandler handler, void *userdata)
+{
+  strbuf sectbuf = {0}, namebuf = {0}, valuebuf = {0};
+  iniconf_view sect = { "", 0 }, name, value;
+  cursor_t cursor, *cp = &cursor;
+  int r = 0;
+
+  if (!buf) return 0;
+
+  cp->p = buf;
+  cp->end = buf + len;
+  cp->lineno = 1;
+
+  /* skip the BOM; like skipbom, drop a partial one */
+  if (len > 0 && (unsigned char) buf[0] == 0xEF) {
+    cp->p++;
+    if (len > 1 && (unsigned char) buf[1] == 0xBB) {
+      cp->p++;
+      if (len > 2 && (unsigned char) buf[2] == 0xBF) cp->p++;
+    }
+  }
+
+  for (;;) {
+    skip_lines(cp);
+    if (cp->p >= cp->end) break;
+    if (*cp->p == '#' || *cp->p == ';') { /* comment */
+      cp->p = findany(cp->p, cp->end, '\n', '\n', '\r', '\r');
+      next_line(cp);
+    }
+    else if (*cp->p == '[') { /* section */
+      cp->p++;
+      if (scan_view(cp, ']', &sectbuf, &sect, 1) < 0) { r = -1; break; }
+      if (cp->p < cp->end && *cp->p == ']') cp->p++;
+      else next_line(cp);
+    }
+    else { /* name = value */
+      size_t lineno = cp->lineno;
+
+      if (scan_view(cp, '=', &namebuf, &name, 0) < 0) { r = -1; break; }
+
+      value.ptr = "";
+      value.len = 0;
+      if (cp->p < cp->end && *cp->p == '=') {
+        cp->p++;
+        if (scan_view(cp, '\0', &valuebuf, &value, 0) < 0) { r = -1; break; }
+      }
+
+      /* skip the newline (or the \0 that ended the value) */
+      if (cp->p < cp->end && *cp->p == '\0') cp->p++;
+      else next_line(cp);
+
+      if (handler && name.len > 0) {
+        r = handler(sect, name, value, lineno, userdata);
+        if (r != 0) break; /* stop parsing */
+      }
+      /* else: do not call handler on empty name */
+    }
+  }
+
+  sbfree(&sectbuf);
+  sbfree(&namebuf);
+  sbfree(&valuebuf);
+
+  return r;
+}
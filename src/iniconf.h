@@ -2,11 +2,18 @@
 #define INICONF_H
 
 #include <stddef.h>
+#include <stdint.h>
 #include <stdio.h>
 
 /* The callback function invoked for each config setting */
 typedef int (*iniconf_handler)(const char *section, const char *name, const char *value, size_t lineno, void *userdata);
 
+/* A piece of the input buffer: ptr[0..len), not zero-terminated */
+typedef struct iniconf_view { const char *ptr; size_t len; } iniconf_view;
+
+/* The callback function invoked by iniconf_mem and iniconf_map */
+typedef int (*iniconf_viewhandler)(iniconf_view section, iniconf_view name, iniconf_view value, size_t lineno, void *userdata);
+
 /* Signature of a custom reader function */
 typedef int (*iniconf_reader)(void *readerstate);
 
@@ -16,4 +23,51 @@ int iniconf_fp(FILE *fp, iniconf_handler handler, void *userdata);
 int iniconf_sz(const char *sz, iniconf_handler handler, void *userdata);
 int iniconf_rf(iniconf_reader rf, void *rfstate, iniconf_handler handler, void *userdata);
 
+int iniconf_mem(const char *buf, size_t len, iniconf_viewhandler handler, void *userdata);
+int iniconf_map(const char *fn, iniconf_viewhandler handler, void *userdata);
+
+/* Parse sections on up to nthreads threads (<= 0: one per CPU) */
+#define INICONF_UNORDERED 1  /* call handler from the threads, in any order */
+int iniconf_par(const char *buf, size_t len, int nthreads, int flags, iniconf_viewhandler handler, void *userdata);
+int iniconf_mappar(const char *fn, int nthreads, int flags, iniconf_viewhandler handler, void *userdata);
+
+/* Batches of entries for a batch handler (views valid during the call) */
+typedef struct iniconf_entry { iniconf_view section, name, value; size_t lineno; } iniconf_entry;
+typedef int (*iniconf_batchhandler)(const iniconf_entry entries[], size_t n, void *userdata);
+int iniconf_batch(const char *buf, size_t len, size_t batchsize, iniconf_batchhandler handler, void *userdata);
+int iniconf_mapbatch(const char *fn, size_t batchsize, iniconf_batchhandler handler, void *userdata);
+
+/* An immutable store of all entries, indexed by (section,name) */
+typedef struct iniconf_store iniconf_store;
+
+/* Return the new store, or null (and errno set) on error */
+iniconf_store *iniconf_load(const char *fn);
+iniconf_store *iniconf_loadmem(const char *buf, size_t len);
+void iniconf_free(iniconf_store *sp);
+
+/* Binary cache: compile once, map at startup if still fresh */
+int iniconf_compile(const char *inifn, const char *cachefn);
+iniconf_store *iniconf_open(const char *inifn, const char *cachefn);
+int iniconf_cached(const iniconf_store *sp);
+
+/* Lookups return dflt if there is no such entry (or not of this type) */
+size_t iniconf_count(const iniconf_store *sp);
+const char *iniconf_get(const iniconf_store *sp, const char *section, const char *name, const char *dflt);
+int64_t iniconf_getint(const iniconf_store *sp, const char *section, const char *name, int64_t dflt);
+int iniconf_getbool(const iniconf_store *sp, const char *section, const char *name, int dflt);
+int64_t iniconf_getdur(const iniconf_store *sp, const char *section, const char *name, int64_t dflt);
+size_t iniconf_lineno(const iniconf_store *sp, const char *section, const char *name);
+
+/* Hot reloading: readers get snapshots without locking */
+typedef struct iniconf_live iniconf_live;
+
+iniconf_live *iniconf_live_open(const char *fn);
+int iniconf_live_reload(iniconf_live *lp); /* 1 if new, 0 if unchanged, -1 on error */
+void iniconf_live_close(iniconf_live *lp);
+
+int iniconf_live_join(iniconf_live *lp); /* once per reader thread */
+void iniconf_live_leave(iniconf_live *lp, int id);
+const iniconf_store *iniconf_live_enter(iniconf_live *lp, int id);
+void iniconf_live_exit(iniconf_live *lp, int id);
+
 #endif
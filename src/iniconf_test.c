@@ -2,9 +2,11 @@
 
 #include "test.h"
 
+#include <pthread.h>
 #include <stdio.h>
 
 #include "iniconf.h"
+#include "strbuf.h"
 
 #define BOM "\xEF\xBB\xBF"  /* UTF-8 encoded BOM */
 
@@ -33,6 +35,107 @@ handler(const char *sect, const char *name, const char *value, size_t lineno, vo
   return 0;
 }
 
+typedef struct {
+  const char *buf;
+  size_t len;
+  int count;
+  int inplace;  /* #names and values that point into buf */
+  char last[64];
+} viewstate;
+
+static int
+viewhandler(iniconf_view sect, iniconf_view name, iniconf_view value, size_t lineno, void *userdata)
+{
+  viewstate *vs = (viewstate *) userdata;
+  const char *end = vs->buf + vs->len;
+
+  vs->count += 1;
+  if (vs->buf <= name.ptr && name.ptr + name.len <= end) vs->inplace++;
+  if (vs->buf <= value.ptr && value.ptr + value.len <= end) vs->inplace++;
+  snprintf(vs->last, sizeof vs->last, "%.*s:%.*s=%.*s@%zu",
+    (int) sect.len, sect.ptr, (int) name.len, name.ptr,
+    (int) value.len, value.ptr, lineno);
+  return 0;
+}
+
+typedef struct {
+  size_t count;
+  size_t linesum;   /* sum of line numbers */
+  size_t hash;      /* depends on order */
+  int stopat;       /* return 1 after so many entries */
+} digest;
+
+static int
+digesthandler(iniconf_view sect, iniconf_view name, iniconf_view value, size_t lineno, void *userdata)
+{ /* thread-safe, for INICONF_UNORDERED */
+  digest *dp = (digest *) userdata;
+  size_t i, h = lineno;
+  for (i = 0; i < sect.len; i++) h = h * 31 + (unsigned char) sect.ptr[i];
+  for (i = 0; i < name.len; i++) h = h * 31 + (unsigned char) name.ptr[i];
+  for (i = 0; i < value.len; i++) h = h * 31 + (unsigned char) value.ptr[i];
+  if (__atomic_add_fetch(&dp->count, 1, __ATOMIC_RELAXED) == (size_t) dp->stopat) return 1;
+  __atomic_add_fetch(&dp->linesum, lineno, __ATOMIC_RELAXED);
+  dp->hash = dp->hash * 7 + h; /* racy if unordered, but not checked */
+  return 0;
+}
+
+typedef struct {
+  digest d;
+  size_t nbatches;
+  size_t maxbatch;
+} batchdigest;
+
+static int
+batchhandler(const iniconf_entry entries[], size_t n, void *userdata)
+{
+  batchdigest *bp = (batchdigest *) userdata;
+  size_t i;
+  int r;
+  bp->nbatches += 1;
+  if (n > bp->maxbatch) bp->maxbatch = n;
+  for (i = 0; i < n; i++) {
+    r = digesthandler(entries[i].section, entries[i].name, entries[i].value,
+                      entries[i].lineno, &bp->d);
+    if (r) return r;
+  }
+  return 0;
+}
+
+struct reader {
+  iniconf_live *lp;
+  int *stop;
+  long reads, bad;
+};
+
+static void *
+reader(void *arg)
+{ /* read snapshots until stopped: x and y must agree, and never go back */
+  struct reader *rp = (struct reader *) arg;
+  const iniconf_store *st;
+  int64_t x, y, last = 0;
+  int id = iniconf_live_join(rp->lp);
+  if (id < 0) { rp->bad++; return 0; }
+  while (!__atomic_load_n(rp->stop, __ATOMIC_ACQUIRE)) {
+    st = iniconf_live_enter(rp->lp, id);
+    x = iniconf_getint(st, "a", "x", -1);
+    y = iniconf_getint(st, "b", "y", -2);
+    iniconf_live_exit(rp->lp, id);
+    if (x != y || x < last) rp->bad++;
+    last = x;
+    rp->reads++;
+  }
+  iniconf_live_leave(rp->lp, id);
+  return 0;
+}
+
+static void
+writeconf(const char *fn, int n)
+{
+  FILE *fp = fopen(fn, "w");
+  fprintf(fp, "[a]\nx = %d\n[b]\ny = %d\n", n, n);
+  fclose(fp);
+}
+
 void
 iniconf_test(int *pnumpass, int *pnumfail)
 {
@@ -107,6 +210,245 @@ iniconf_test(int *pnumpass, int *pnumfail)
   r = iniconf_sz(BOM "foo=bar" BOM, handler, &exp6);
   TEST("BOM", r == 0);
 
+  HEADING("Testing iniconf_mem/iniconf_map");
+
+  {
+    const char text[] = "[s]\r\na = 1\r\nb = two\\\r\n lines\r\nc = \\x ; \\\\ \n[t\\\n u ] d= 4 XX";
+    viewstate vs = { text, sizeof text - 4, 0, 0, "" };
+    r = iniconf_mem(vs.buf, vs.len, viewhandler, &vs);
+    TEST("views", r == 0 && vs.count == 4 && vs.inplace == 7
+      && STREQ(vs.last, "t u:d=4@7"));
+  }
+  {
+    const char text[] = "a=1\0ignored\nb";
+    viewstate vs = { text, sizeof text - 1, 0, 0, "" };
+    r = iniconf_mem(vs.buf, vs.len, viewhandler, &vs);
+    TEST("NUL ends value", r == 0 && vs.count == 3 && STREQ(vs.last, ":b=@2"));
+  }
+
+  fp = fopen("iniconf_test.tmp", "w");
+  fputs(BOM "[user]\nname = John\nmail = john@smith.com\n", fp);
+  fclose(fp);
+  {
+    const char *fn = "iniconf_test.tmp";
+    viewstate vs = { "", 0, 0, 0, "" };
+    r = iniconf_map(fn, viewhandler, &vs);
+    TEST("iniconf_map", r == 0 && vs.count == 2 && STREQ(vs.last, "user:mail=john@smith.com@3"));
+    const char *s7[] = { "user", "user" };
+    const char *n7[] = { "name", "mail" };
+    const char *v7[] = { "John", "john@smith.com" };
+    expected exp7 = { 0, 2, s7, n7, v7 };
+    r = iniconf_fn(fn, handler, &exp7);
+    TEST("iniconf_fn", r == 0 && exp7.index == 2);
+    remove(fn);
+  }
+  TEST("iniconf_fn no file", iniconf_fn("/no/such/file.ini", handler, 0) == -1);
+
+  HEADING("Testing iniconf_par");
+  {
+    strbuf sb = {0};
+    digest d0 = {0, 0, 0, 0}, d1 = {0, 0, 0, 0}, d2 = {0, 0, 0, 0}, d3 = {0, 0, 0, 3333};
+    int i;
+    sbaddz(&sb, "top = level\n");
+    for (i = 0; i < 5000; i++) { /* about 300K bytes, so several chunks */
+      sbaddf(&sb, "[section %d]\r\n  key = value %d\n", i, i);
+      sbaddf(&sb, "long = first \\\n[not a section]\n# comment \\\n");
+      sbaddf(&sb, "  [section %d.%d] more = %d\rnext\\\r\n=x\n\n", i, i, i);
+    }
+    r = iniconf_mem(sbptr(&sb), sblen(&sb), digesthandler, &d0);
+    TEST("par sequential", r == 0 && d0.count == 1 + 5000*4);
+    r = iniconf_par(sbptr(&sb), sblen(&sb), 4, 0, digesthandler, &d1);
+    TEST("par ordered", r == 0 && d1.count == d0.count &&
+         d1.linesum == d0.linesum && d1.hash == d0.hash);
+    r = iniconf_par(sbptr(&sb), sblen(&sb), 4, INICONF_UNORDERED, digesthandler, &d2);
+    TEST("par unordered", r == 0 && d2.count == d0.count && d2.linesum == d0.linesum);
+    r = iniconf_par(sbptr(&sb), sblen(&sb), 4, 0, digesthandler, &d3);
+    TEST("par stop", r == 1 && d3.count == 3333);
+    r = iniconf_par(sbptr(&sb), 9, 4, 0, digesthandler, &d3);
+    TEST("par small", r == 0 && d3.count == 3334);
+
+    HEADING("Testing iniconf_batch");
+    {
+      batchdigest b0 = {{0, 0, 0, 0}, 0, 0}, b1 = {{0, 0, 0, 0}, 0, 0};
+      batchdigest b2 = {{0, 0, 0, 100}, 0, 0};
+      r = iniconf_batch(sbptr(&sb), sblen(&sb), 7, batchhandler, &b0);
+      TEST("batch", r == 0 && b0.d.count == d0.count && b0.d.linesum == d0.linesum &&
+           b0.d.hash == d0.hash);
+      TEST("batch size", b0.maxbatch == 7 && b0.nbatches == (d0.count + 6) / 7);
+      r = iniconf_batch(sbptr(&sb), sblen(&sb), 0, batchhandler, &b1);
+      TEST("batch default", r == 0 && b1.d.hash == d0.hash && b1.maxbatch == 1024);
+      r = iniconf_batch(sbptr(&sb), sblen(&sb), 0, batchhandler, &b2);
+      TEST("batch stop", r == 1 && b2.d.count == 100 && b2.nbatches == 1);
+      fp = fopen("iniconf_test.tmp", "w");
+      fwrite(sbptr(&sb), 1, sblen(&sb), fp);
+      fclose(fp);
+      memset(&b1, 0, sizeof b1);
+      r = iniconf_mapbatch("iniconf_test.tmp", 5000, batchhandler, &b1);
+      TEST("mapbatch", r == 0 && b1.d.hash == d0.hash && b1.nbatches == 5);
+      remove("iniconf_test.tmp");
+    }
+    sbfree(&sb);
+  }
+
+  HEADING("Testing iniconf_load");
+
+  {
+    const char text[] = "top = level\n[net]\nport = 8080\nport = 8081\n"
+      "debug = Yes\ntimeout = 1m30s\nretry = 250ms\nname = -12x\n"
+      "[disk]\nport = off\nquota = 0\n";
+    iniconf_store *st = iniconf_loadmem(text, sizeof text - 1);
+    TEST("loadmem", st != 0 && iniconf_count(st) == 8);
+    TEST("get", STREQ(iniconf_get(st, "", "top", 0), "level")
+      && STREQ(iniconf_get(st, 0, "top", 0), "level")
+      && STREQ(iniconf_get(st, "net", "name", 0), "-12x")
+      && iniconf_get(st, "net", "top", 0) == 0
+      && STREQ(iniconf_get(st, "nope", "port", "dflt"), "dflt"));
+    TEST("last wins", iniconf_getint(st, "net", "port", 0) == 8081
+      && iniconf_lineno(st, "net", "port") == 4);
+    TEST("getint", iniconf_getint(st, "net", "name", -1) == -1
+      && iniconf_getint(st, "disk", "quota", -1) == 0);
+    TEST("getbool", iniconf_getbool(st, "net", "debug", 0) == 1
+      && iniconf_getbool(st, "disk", "port", 1) == 0
+      && iniconf_getbool(st, "disk", "quota", 1) == 0
+      && iniconf_getbool(st, "net", "port", -1) == -1);
+    TEST("getdur", iniconf_getdur(st, "net", "timeout", 0) == 90000
+      && iniconf_getdur(st, "net", "retry", 0) == 250
+      && iniconf_getdur(st, "disk", "quota", -1) == 0
+      && iniconf_getdur(st, "net", "port", -1) == -1);
+    iniconf_free(st);
+  }
+  {
+    strbuf sb = {0};
+    iniconf_store *st;
+    int i, ok = 1;
+    for (i = 0; i < 5000; i++) {
+      if (i % 10 == 0) sbaddf(&sb, "[s%d]\n", i / 10);
+      sbaddf(&sb, "k%d = %d\n", i, i);
+    }
+    st = iniconf_loadmem(sbptr(&sb), sblen(&sb));
+    for (i = 0; i < 5000 && st; i++) {
+      char sect[16], name[16];
+      snprintf(sect, sizeof sect, "s%d", i / 10);
+      snprintf(name, sizeof name, "k%d", i);
+      if (iniconf_getint(st, sect, name, -1) != i) ok = 0;
+      snprintf(sect, sizeof sect, "s%d", i / 10 + 1);
+      if (iniconf_get(st, sect, name, 0)) ok = 0;
+    }
+    TEST("perfect hash 5000", st && iniconf_count(st) == 5000 && ok);
+    iniconf_free(st);
+    sbfree(&sb);
+  }
+  {
+    iniconf_store *st = iniconf_loadmem("", 0);
+    TEST("load empty", st && iniconf_count(st) == 0 && !iniconf_get(st, "", "x", 0));
+    iniconf_free(st);
+  }
+  TEST("load no file", iniconf_load("/no/such/file.ini") == 0);
+
+  HEADING("Testing iniconf_compile");
+
+  fp = fopen("iniconf_test.tmp", "w");
+  fputs("[a]\nx = 1\nname = old\n", fp);
+  fclose(fp);
+  {
+    const char *fn = "iniconf_test.tmp", *cfn = "iniconf_test.cache";
+    iniconf_store *st;
+    TEST("compile", iniconf_compile(fn, cfn) == 0);
+    st = iniconf_open(fn, cfn);
+    TEST("open cached", st && iniconf_cached(st));
+    TEST("open cached get", iniconf_getint(st, "a", "x", 0) == 1 &&
+         !strcmp(iniconf_get(st, "a", "name", ""), "old") && iniconf_count(st) == 2);
+    TEST("open cached lineno", iniconf_lineno(st, "a", "name") == 3);
+    iniconf_free(st);
+    fp = fopen(fn, "w");
+    fputs("[a]\nx = 2\nname = new\n", fp); /* same size */
+    fclose(fp);
+    st = iniconf_open(fn, cfn);
+    TEST("open stale", st && !iniconf_cached(st) && iniconf_getint(st, "a", "x", 0) == 2);
+    iniconf_free(st);
+    st = iniconf_open(fn, "/no/such/file.cache");
+    TEST("open no cache", st && !iniconf_cached(st) && iniconf_getint(st, "a", "x", 0) == 2);
+    iniconf_free(st);
+    fp = fopen(cfn, "w");
+    fputs("INIC but not a cache file", fp);
+    fclose(fp);
+    st = iniconf_open(fn, cfn);
+    TEST("open bad cache", st && !iniconf_cached(st));
+    iniconf_free(st);
+    TEST("compile no file", iniconf_compile("/no/such/file.ini", cfn) == -1);
+    TEST("open no file", iniconf_open("/no/such/file.ini", cfn) == 0);
+    remove(cfn);
+    remove(fn);
+  }
+
+  HEADING("Testing iniconf_live");
+
+  fp = fopen("iniconf_test.tmp", "w");
+  fputs("[a]\nx = 1\n", fp);
+  fclose(fp);
+  {
+    const char *fn = "iniconf_test.tmp";
+    iniconf_live *lp = iniconf_live_open(fn);
+    const iniconf_store *st, *old;
+    int id = iniconf_live_join(lp);
+    TEST("live open", lp != 0 && id >= 0);
+    old = iniconf_live_enter(lp, id);
+    TEST("live enter", iniconf_getint(old, "a", "x", 0) == 1);
+    TEST("live unchanged", iniconf_live_reload(lp) == 0);
+    fp = fopen(fn, "w");
+    fputs("[a]\nx = 1\n", fp); /* same content */
+    fclose(fp);
+    TEST("live same content", iniconf_live_reload(lp) == 0);
+    fp = fopen(fn, "w");
+    fputs("[a]\nx = 2\n", fp);
+    fclose(fp);
+    TEST("live reload", iniconf_live_reload(lp) == 1);
+    TEST("live old snapshot", iniconf_getint(old, "a", "x", 0) == 1);
+    iniconf_live_exit(lp, id);
+    st = iniconf_live_enter(lp, id);
+    TEST("live new snapshot", st != old && iniconf_getint(st, "a", "x", 0) == 2);
+    iniconf_live_exit(lp, id);
+    iniconf_live_leave(lp, id);
+    remove(fn);
+    TEST("live no file", iniconf_live_reload(lp) == -1 && iniconf_live_enter(lp, 0) == st);
+    iniconf_live_exit(lp, 0);
+    iniconf_live_close(lp);
+  }
+
+  writeconf("iniconf_test.tmp", 0);
+  {
+    enum { NREADERS = 4, NRELOADS = 200 };
+    const char *fn = "iniconf_test.tmp";
+    struct reader readers[NREADERS];
+    pthread_t threads[NREADERS];
+    iniconf_live *lp = iniconf_live_open(fn);
+    int i, n, stop = 0, reloads = 0, started = 0;
+    long reads = 0, bad = 0;
+    for (i = 0; lp && i < NREADERS; i++) {
+      readers[i].lp = lp;
+      readers[i].stop = &stop;
+      readers[i].reads = readers[i].bad = 0;
+      if (pthread_create(&threads[i], 0, reader, &readers[i]) == 0) started++;
+    }
+    for (n = 1; n <= NRELOADS && started == NREADERS; n++) {
+      writeconf(fn, n);
+      reloads += iniconf_live_reload(lp) == 1;
+    }
+    __atomic_store_n(&stop, 1, __ATOMIC_RELEASE);
+    for (i = 0; i < started; i++) {
+      pthread_join(threads[i], 0);
+      reads += readers[i].reads;
+      bad += readers[i].bad;
+    }
+    if (started == NREADERS) {
+      TEST("live concurrent reloads", reloads == NRELOADS);
+      TEST("live concurrent readers", reads > 0 && bad == 0);
+    }
+    else INFO("live concurrent: %s", "skipped, cannot start threads (memory limited by strbuf_test with -s)");
+    iniconf_live_close(lp);
+    remove(fn);
+  }
+
   *pnumpass += numpass;
   *pnumfail += numfail;
 }
@@ -0,0 +1,29 @@
+#ifndef INIFILE_H
+#define INIFILE_H
+
+/* Internal to the iniconf sources (iniconf.c, inistore.c,
+ * inilive.c), not part of the API: reading a config file */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/stat.h>
+
+#include "strbuf.h"
+
+/* The contents of a file: mapped, or else read into buf */
+struct inifile {
+  const char *ptr;  /* ptr[0..len), never null */
+  size_t len;
+  void *map;        /* the mapping, or null if read */
+  strbuf buf;
+};
+
+/* Map fd if st says it is a regular file, else (or if st is null)
+ * read it; return 0, or -1 on error */
+int inifile_read(struct inifile *fp, int fd, const struct stat *st);
+void inifile_free(struct inifile *fp);
+
+/* FNV-1a hash of the contents, to tell whether a file changed */
+uint64_t inifile_hash(const char *p, size_t n);
+
+#endif
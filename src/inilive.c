@@ -0,0 +1,244 @@
+/* required for st_mtim */
+#define _POSIX_C_SOURCE 200809L
+
+#include "iniconf.h"
+#include "inifile.h"
+#include "buf.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+/* Hot reload of a config file: the current store (a snapshot)
+ * is published through a pointer; a reload builds a new store
+ * and swaps the pointer atomically. Readers never lock or wait.
+ *
+ * The old store must not be freed while readers may still use
+ * it. We use epoch-based reclamation: a reader announces the
+ * global epoch in its slot when it enters (and zero when it
+ * exits); a reload publishes the new store, then advances the
+ * epoch and retires the old store with the new epoch. A retired
+ * store is freed once all active readers have announced an epoch
+ * at least that large, for they must have loaded the new pointer.
+ *
+ * Reload skips parsing if the file's inode, size and mtime are
+ * unchanged, or else if its content hash (FNV-1a) is unchanged.
+ * As mtime may have a coarse resolution, a file modified within
+ * the last two seconds (racy, as git calls it) is always hashed.
+ */
+
+#define MAXREADERS 64
+#define CACHELINE 64
+
+struct slot {
+  uint64_t epoch;   /* announced epoch, or 0 if not inside */
+  int used;         /* slot taken by a reader */
+  char pad[CACHELINE - sizeof (uint64_t) - sizeof (int)];
+};
+
+struct retired { iniconf_store *st; uint64_t epoch; };
+
+struct iniconf_live {
+  iniconf_store *current;   /* the published snapshot */
+  uint64_t epoch;           /* global epoch, starts at 1 */
+  int reloading;            /* one reload at a time */
+  struct retired *retired;  /* buf.h: waiting to be freed */
+  char *fn;                 /* the file name */
+  dev_t dev;                /* what we know about the file: */
+  ino_t ino;
+  off_t size;
+  struct timespec mtime;
+  uint64_t hash;
+  int racy;                 /* mtime too recent to trust */
+  struct slot slots[MAXREADERS];
+};
+
+#define LOAD(p) __atomic_load_n(p, __ATOMIC_ACQUIRE)
+#define STORE(p, v) __atomic_store_n(p, v, __ATOMIC_RELEASE)
+
+static int
+update(iniconf_live *lp, iniconf_store **pst)
+{ /* if the file changed, load a new store into *pst; return 1
+     if changed, 0 if not, -1 on error */
+  struct inifile file;
+  struct stat st;
+  uint64_t hash;
+  int fd, r = 0, saverr;
+
+  *pst = 0;
+  if ((fd = open(lp->fn, O_RDONLY)) < 0) return -1;
+  if (fstat(fd, &st) < 0) goto fail;
+
+  if (lp->current && !lp->racy && st.st_dev == lp->dev && st.st_ino == lp->ino &&
+      st.st_size == lp->size && st.st_mtim.tv_sec == lp->mtime.tv_sec &&
+      st.st_mtim.tv_nsec == lp->mtime.tv_nsec) {
+    close(fd);
+    return 0; /* same file, same size and mtime */
+  }
+
+  /* read, not map: if the file were truncated while we parse the
+     mapping, touching the pages beyond its end would raise SIGBUS */
+  if (inifile_read(&file, fd, 0) < 0) { inifile_free(&file); goto fail; }
+
+  hash = inifile_hash(file.ptr, file.len);
+  if (!lp->current || hash != lp->hash) {
+    *pst = iniconf_loadmem(file.ptr, file.len);
+    r = *pst ? 1 : -1;
+  }
+
+  inifile_free(&file);
+  saverr = errno;
+  close(fd);
+  errno = saverr;
+
+  if (r >= 0) { /* remember what we saw */
+    lp->dev = st.st_dev;
+    lp->ino = st.st_ino;
+    lp->size = st.st_size;
+    lp->mtime = st.st_mtim;
+    lp->hash = hash;
+    lp->racy = time(0) - st.st_mtim.tv_sec < 2;
+  }
+  return r;
+
+fail:
+  saverr = errno;
+  close(fd);
+  errno = saverr;
+  return -1;
+}
+
+static void
+reclaim(iniconf_live *lp)
+{ /* free retired stores that no reader can be using */
+  uint64_t min = UINT64_MAX, e;
+  size_t i, j, n;
+
+  for (i = 0; i < MAXREADERS; i++) {
+    e = LOAD(&lp->slots[i].epoch);
+    if (e && e < min) min = e;
+  }
+
+  n = buf_size(lp->retired);
+  for (i = j = 0; i < n; i++) {
+    if (lp->retired[i].epoch <= min) iniconf_free(lp->retired[i].st);
+    else lp->retired[j++] = lp->retired[i];
+  }
+  buf_trunc(lp->retired, j);
+}
+
+/** Load the config file fn for hot reloading; null on error */
+iniconf_live *
+iniconf_live_open(const char *fn)
+{
+  iniconf_live *lp;
+  int saverr;
+
+  if (!fn) { errno = EINVAL; return 0; }
+  if (!(lp = calloc(1, sizeof *lp))) return 0;
+  lp->epoch = 1;
+  if (!(lp->fn = malloc(strlen(fn) + 1))) goto fail;
+  strcpy(lp->fn, fn);
+  if (update(lp, &lp->current) < 0) goto fail;
+  return lp;
+
+fail:
+  saverr = errno;
+  free(lp->fn);
+  free(lp);
+  errno = saverr;
+  return 0;
+}
+
+/** Reload the config file if it changed and publish the new
+ *  snapshot; return 1 if published, 0 if unchanged, -1 on error
+ *  (and the current snapshot remains) */
+int
+iniconf_live_reload(iniconf_live *lp)
+{
+  iniconf_store *st, *old;
+  struct retired ret;
+  int r, busy = 0;
+
+  if (!lp) { errno = EINVAL; return -1; }
+  if (!__atomic_compare_exchange_n(&lp->reloading, &busy, 1, 0,
+                                   __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+    errno = EBUSY;
+    return -1;
+  }
+
+  r = update(lp, &st);
+  if (r > 0) {
+    old = __atomic_exchange_n(&lp->current, st, __ATOMIC_SEQ_CST);
+    ret.st = old;
+    ret.epoch = __atomic_add_fetch(&lp->epoch, 1, __ATOMIC_SEQ_CST);
+    buf_push(lp->retired, ret);
+  }
+  __atomic_thread_fence(__ATOMIC_SEQ_CST);
+  reclaim(lp);
+
+  STORE(&lp->reloading, 0);
+  return r;
+}
+
+/** Release everything; there must be no readers left */
+void
+iniconf_live_close(iniconf_live *lp)
+{
+  size_t i;
+  if (!lp) return;
+  for (i = 0; i < buf_size(lp->retired); i++)
+    iniconf_free(lp->retired[i].st);
+  buf_free(lp->retired);
+  iniconf_free(lp->current);
+  free(lp->fn);
+  free(lp);
+}
+
+/** Register a reader thread; return its id, or -1 if too many */
+int
+iniconf_live_join(iniconf_live *lp)
+{
+  int i;
+  for (i = 0; lp && i < MAXREADERS; i++) {
+    int unused = 0;
+    if (__atomic_compare_exchange_n(&lp->slots[i].used, &unused, 1, 0,
+                                    __ATOMIC_ACQ_REL, __ATOMIC_RELAXED))
+      return i;
+  }
+  errno = EAGAIN;
+  return -1;
+}
+
+/** Unregister reader id (which must not be inside) */
+void
+iniconf_live_leave(iniconf_live *lp, int id)
+{
+  if (!lp || id < 0 || id >= MAXREADERS) return;
+  STORE(&lp->slots[id].epoch, 0);
+  STORE(&lp->slots[id].used, 0);
+}
+
+/** Begin reading: return the current snapshot, which remains
+ *  valid until iniconf_live_exit (no locking, no waiting) */
+const iniconf_store *
+iniconf_live_enter(iniconf_live *lp, int id)
+{
+  if (!lp || id < 0 || id >= MAXREADERS) return 0;
+  __atomic_store_n(&lp->slots[id].epoch, LOAD(&lp->epoch), __ATOMIC_RELAXED);
+  __atomic_thread_fence(__ATOMIC_SEQ_CST); /* announce before loading */
+  return LOAD(&lp->current);
+}
+
+/** Done reading: the snapshot may no longer be used */
+void
+iniconf_live_exit(iniconf_live *lp, int id)
+{
+  if (!lp || id < 0 || id >= MAXREADERS) return;
+  STORE(&lp->slots[id].epoch, 0);
+}
@@ -0,0 +1,335 @@
+/* required for pthreads, sysconf */
+#define _POSIX_C_SOURCE 200112L
+
+#include "iniconf.h"
+#include "strbuf.h"
+#include "buf.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <string.h>
+#include <unistd.h>
+
+/* Parallel parsing: the buffer is cut into chunks at section
+ * boundaries, and each chunk is parsed by iniconf_mem on a thread
+ * of its own. Cutting takes a short scan from each cut point to
+ * the next line that begins (after blanks) with a [ and does not
+ * continue the line before (which would end in a backslash).
+ * The parser is at top level after every line break that is not
+ * escaped, so such a line begins a section. (A comment does not
+ * continue over a backslash newline, so we may miss a place to
+ * cut, but we never cut in the wrong place.)
+ *
+ * The threads first count the lines in their chunks, which gives
+ * the first line number of each chunk. Then, to deliver entries
+ * in file order, each thread collects its entries (as views) and
+ * the calling thread passes them to the handler chunk by chunk, as
+ * the threads finish. If the order does not matter, the threads
+ * call the handler themselves, concurrently.
+ *
+ * Batching uses the same collector on the whole buffer, and passes
+ * the entries to the batch handler whenever it has collected enough;
+ * the arrays are then reused for the next batch.
+ */
+
+#define MAXTHREADS 64
+#define MINCHUNK 65536   /* not worth a thread if smaller */
+
+#define ISBLANK(c) ((c) == ' ' || (c) == '\t' || (c) == '\v' || (c) == '\f')
+#define ISBREAK(c) ((c) == '\n' || (c) == '\r')
+
+#define LOAD(p) __atomic_load_n(p, __ATOMIC_ACQUIRE)
+#define STORE(p, v) __atomic_store_n(p, v, __ATOMIC_RELEASE)
+
+#define BATCHSIZE 1024
+
+struct fixup {
+  size_t index;          /* of the entry */
+  size_t offset;         /* of the view's text in the copy */
+  int which;             /* 0: section, 1: name, 2: value */
+};
+
+struct chunk {
+  const char *buf;       /* the chunk: buf[0..len) */
+  size_t len;
+  size_t lineno;         /* line number of buf[0] */
+  size_t nlines;         /* #line breaks in the chunk */
+  const char *base;      /* the whole buffer: base[0..size) */
+  size_t size;
+  iniconf_viewhandler handler;  /* if unordered */
+  iniconf_batchhandler batch;   /* if batching */
+  size_t batchsize;
+  void *userdata;
+  int *stop;             /* shared: set to stop all threads */
+  int stopped;           /* stopped because of stop */
+  iniconf_entry *entries;  /* buf.h: collected entries */
+  struct fixup *fixups;  /* buf.h: views not into the buffer */
+  strbuf copy;           /* text of those views */
+  int result;            /* of iniconf_mem */
+  int err;               /* errno if result is -1 */
+  int started;           /* thread was started */
+  pthread_t thread;
+};
+
+static int
+escaped(const char *buf, const char *p)
+{ /* p is at a line start: does the line before end in a backslash? */
+  const char *q = p - 1;  /* the line break */
+  if (*q == '\n' && q > buf && q[-1] == '\r') q--;
+  return q > buf && q[-1] == '\\';
+}
+
+static const char *
+findsection(const char *buf, const char *p, const char *end)
+{ /* start of the first line after p that begins a section, or end */
+  const char *q;
+  while (p < end) {
+    while (p < end && !ISBREAK(*p)) p++;
+    if (p >= end) break;
+    if (*p == '\r' && p+1 < end && p[1] == '\n') p++;
+    p++; /* at a line start */
+    for (q = p; q < end && ISBLANK(*q); q++) {}
+    if (q < end && *q == '[' && !escaped(buf, p)) return p;
+  }
+  return end;
+}
+
+static size_t
+countlines(const char *p, const char *end)
+{ /* count line breaks like the parser: LF, CRLF, or CR */
+  size_t n = 0;
+  if (p >= end) return 0;
+  for (--end; p < end; p++)
+    n += (*p == '\n') | (*p == '\r' && p[1] != '\n');
+  return n + ISBREAK(*p);
+}
+
+static int
+inplace(const struct chunk *cp, iniconf_view v)
+{ /* does view v point into the buffer? */
+  return cp->base <= v.ptr && v.ptr + v.len <= cp->base + cp->size;
+}
+
+static iniconf_view *
+viewof(iniconf_entry *ep, int which)
+{
+  return which == 0 ? &ep->section : which == 1 ? &ep->name : &ep->value;
+}
+
+static void
+fixup(struct chunk *cp)
+{ /* point copied views into the copy, which no longer moves */
+  size_t i;
+  for (i = 0; i < buf_size(cp->fixups); i++) {
+    const struct fixup *fp = &cp->fixups[i];
+    viewof(&cp->entries[fp->index], fp->which)->ptr = sbptr(&cp->copy) + fp->offset;
+  }
+}
+
+static int
+flush(struct chunk *cp)
+{ /* pass the collected entries to the batch handler, reset */
+  int r;
+  fixup(cp);
+  r = cp->batch(cp->entries, buf_size(cp->entries), cp->userdata);
+  buf_clear(cp->entries);
+  buf_clear(cp->fixups);
+  sbtrunc(&cp->copy, 0);
+  return r;
+}
+
+static int
+collect(iniconf_view sect, iniconf_view name, iniconf_view value, size_t lineno, void *userdata)
+{ /* append entry to the chunk's entries, copy views not in place */
+  struct chunk *cp = (struct chunk *) userdata;
+  iniconf_entry entry;
+  struct fixup fix;
+  iniconf_view *vp;
+
+  if (cp->stop && LOAD(cp->stop)) { cp->stopped = 1; return 1; }
+
+  entry.section = sect;
+  entry.name = name;
+  entry.value = value;
+  entry.lineno = cp->lineno + lineno - 1;
+  fix.index = buf_size(cp->entries);
+  for (fix.which = 0; fix.which < 3; fix.which++) {
+    vp = viewof(&entry, fix.which);
+    if (vp->len == 0) vp->ptr = "";
+    else if (!inplace(cp, *vp)) { /* joined by the parser */
+      fix.offset = sblen(&cp->copy);
+      sbaddb(&cp->copy, vp->ptr, vp->len);
+      buf_push(cp->fixups, fix);
+    }
+  }
+  if (sbfailed(&cp->copy)) { errno = ENOMEM; return -1; }
+  buf_push(cp->entries, entry);
+
+  if (cp->batch && buf_size(cp->entries) >= cp->batchsize) return flush(cp);
+  return 0;
+}
+
+static int
+relay(iniconf_view sect, iniconf_view name, iniconf_view value, size_t lineno, void *userdata)
+{ /* pass entry on to the handler, in this thread */
+  struct chunk *cp = (struct chunk *) userdata;
+  if (LOAD(cp->stop)) { cp->stopped = 1; return 1; }
+  return cp->handler(sect, name, value, cp->lineno + lineno - 1, cp->userdata);
+}
+
+static void *
+count(void *arg)
+{
+  struct chunk *cp = (struct chunk *) arg;
+  cp->nlines = countlines(cp->buf, cp->buf + cp->len);
+  return 0;
+}
+
+static void *
+parse(void *arg)
+{
+  struct chunk *cp = (struct chunk *) arg;
+  int r;
+
+  r = iniconf_mem(cp->buf, cp->len, cp->handler ? relay : collect, cp);
+  if (cp->stopped) r = 0;
+  if (r == -1) cp->err = errno;
+  if (r != 0) STORE(cp->stop, 1);
+  cp->result = r;
+  return 0;
+}
+
+static void
+start(struct chunk *cp, void *(*fun)(void *))
+{ /* run fun(cp) on a new thread, or in this one if that fails */
+  cp->started = pthread_create(&cp->thread, 0, fun, cp) == 0;
+  if (!cp->started) fun(cp);
+}
+
+static void
+join(struct chunk *cp)
+{
+  if (cp->started) pthread_join(cp->thread, 0);
+  cp->started = 0;
+}
+
+static int
+deliver(struct chunk *cp, iniconf_viewhandler handler, void *userdata)
+{ /* pass the chunk's collected entries to handler, in order */
+  const iniconf_entry *ep;
+  size_t i;
+  int r;
+
+  fixup(cp);
+  for (i = 0; i < buf_size(cp->entries); i++) {
+    ep = &cp->entries[i];
+    r = handler(ep->section, ep->name, ep->value, ep->lineno, userdata);
+    if (r != 0) return r; /* stop parsing */
+  }
+  return 0;
+}
+
+static int
+ncpus(void)
+{
+#ifdef _SC_NPROCESSORS_ONLN
+  long n = sysconf(_SC_NPROCESSORS_ONLN);
+  if (n > 0) return n < MAXTHREADS ? (int) n : MAXTHREADS;
+#endif
+  return 1;
+}
+
+/** Like iniconf_mem, but parse the sections of buf on up to
+ *  nthreads threads (if <= 0, one per CPU); pass entries to the
+ *  handler in file order, or with INICONF_UNORDERED in flags,
+ *  call the handler from the threads (concurrently, in any order) */
+int
+iniconf_par(const char *buf, size_t len, int nthreads, int flags,
+            iniconf_viewhandler handler, void *userdata)
+{
+  struct chunk chunks[MAXTHREADS];
+  const char *p, *q, *end;
+  size_t lineno;
+  int i, n, r = 0, err = 0, stop = 0;
+
+  if (!buf) return 0;
+  if (!handler) return iniconf_mem(buf, len, 0, 0);
+
+  if (nthreads <= 0) nthreads = ncpus();
+  if (nthreads > MAXTHREADS) nthreads = MAXTHREADS;
+  if ((size_t) nthreads > len / MINCHUNK) nthreads = (int) (len / MINCHUNK);
+
+  /* cut into at most nthreads chunks at section starts */
+  end = buf + len;
+  for (n = 0, p = buf; p < end && n < nthreads; n++, p = q) {
+    q = buf + len / nthreads * (n+1);
+    q = n+1 < nthreads ? findsection(buf, q > p ? q : p, end) : end;
+    memset(&chunks[n], 0, sizeof chunks[n]);
+    chunks[n].buf = p;
+    chunks[n].len = q - p;
+    chunks[n].base = buf;
+    chunks[n].size = len;
+    chunks[n].stop = &stop;
+    if (flags & INICONF_UNORDERED) {
+      chunks[n].handler = handler;
+      chunks[n].userdata = userdata;
+    }
+  }
+  if (n <= 1) return iniconf_mem(buf, len, handler, userdata);
+
+  for (i = 0; i < n; i++) start(&chunks[i], count);
+  for (i = 0, lineno = 1; i < n; i++) {
+    join(&chunks[i]);
+    chunks[i].lineno = lineno;
+    lineno += chunks[i].nlines;
+  }
+
+  for (i = 0; i < n; i++) start(&chunks[i], parse);
+  for (i = 0; i < n; i++) {
+    join(&chunks[i]);
+    if (r == 0 && chunks[i].result != 0) {
+      r = chunks[i].result;
+      err = chunks[i].err;
+    }
+    if (r == 0 && !(flags & INICONF_UNORDERED)) {
+      r = deliver(&chunks[i], handler, userdata);
+      if (r != 0) STORE(&stop, 1);
+    }
+    buf_free(chunks[i].entries);
+    buf_free(chunks[i].fixups);
+    sbfree(&chunks[i].copy);
+  }
+
+  if (r == -1 && err) errno = err;
+  return r;
+}
+
+/** Like iniconf_mem, but pass the entries to the handler in
+ *  batches of up to batchsize (if 0, 1024) entries; the views
+ *  remain valid until the handler returns */
+int
+iniconf_batch(const char *buf, size_t len, size_t batchsize,
+              iniconf_batchhandler handler, void *userdata)
+{
+  struct chunk chunk;
+  int r;
+
+  if (!buf) return 0;
+  if (!handler) return iniconf_mem(buf, len, 0, 0);
+
+  memset(&chunk, 0, sizeof chunk);
+  chunk.buf = chunk.base = buf;
+  chunk.len = chunk.size = len;
+  chunk.lineno = 1;
+  chunk.batch = handler;
+  chunk.batchsize = batchsize ? batchsize : BATCHSIZE;
+  chunk.userdata = userdata;
+
+  r = iniconf_mem(buf, len, collect, &chunk);
+  if (r == 0 && buf_size(chunk.entries) > 0) r = flush(&chunk);
+
+  buf_free(chunk.entries);
+  buf_free(chunk.fixups);
+  sbfree(&chunk.copy);
+  return r;
+}
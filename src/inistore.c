@@ -0,0 +1,744 @@
+/* required for mmap, st_mtim */
+#define _POSIX_C_SOURCE 200809L
+
+#include "iniconf.h"
+#include "inifile.h"
+#include "scan.h"
+#include "strbuf.h"
+#include "buf.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+/* An immutable, indexed store of all entries of a config file.
+ *
+ * The store is one block of memory, without any pointers, so that
+ * it could be written to a file and mapped back in as is:
+ *
+ *   header | entries | displacements | slots | strings
+ *
+ * All strings (sections, names, values) are interned into the
+ * string table, each distinct string once, and referred to by
+ * offset. Values are parsed eagerly as integer, boolean and
+ * duration, so getters never reparse text.
+ *
+ * The index is a minimal-effort perfect hash (hash and displace):
+ * keys (section,name) are grouped into buckets by one part of their
+ * hash; for each bucket, largest first, we search a displacement d
+ * such that slot = h1 + d*h2 (mod nslots) is free for all its keys.
+ * A lookup thus computes one hash and probes exactly one slot.
+ *
+ * A store can be compiled into a cache file: a header that
+ * identifies the source file (size, mtime, content hash),
+ * followed by the store as is. If the source is unchanged,
+ * the cache file is mapped into memory and used right away.
+ */
+
+#define MAGIC 0x494E4931 /* "INI1" */
+#define NOENTRY UINT32_MAX
+#define MAXTRIES (1 << 20) /* per bucket, then try another seed */
+
+#define MAPPED 1
+
+#define ISINT  1
+#define ISBOOL 2
+#define ISTRUE 4
+#define ISDUR  8
+
+struct iniconf_store {
+  uint32_t magic;     /* MAGIC */
+  uint32_t size;      /* total #bytes, including this header */
+  uint32_t nentries;  /* #entries (distinct keys) */
+  uint32_t nbuckets;  /* #displacements */
+  uint32_t nslots;    /* #slots, a power of two */
+  uint32_t seed;      /* of the hash function */
+  uint32_t flags;     /* MAPPED if mapped from a cache file */
+  uint32_t entries;   /* offsets of the parts: */
+  uint32_t disp;
+  uint32_t slots;
+  uint32_t strings;
+};
+
+struct entry {
+  uint32_t section, name, value; /* offsets into strings */
+  uint32_t lineno;
+  uint32_t flags;     /* which typed values are valid */
+  uint32_t unused;
+  int64_t intval;
+  int64_t msecs;      /* duration in milliseconds */
+};
+
+#define PART(sp, type, ofs) ((const type *) ((const char *) (sp) + (sp)->ofs))
+
+static uint64_t
+hashkey(uint32_t seed, const char *sect, size_t slen, const char *name, size_t nlen)
+{ /* FNV-1a over section \0 name, with a final mix */
+  uint64_t h = UINT64_C(14695981039346656037) ^ seed;
+  size_t i;
+  for (i = 0; i < slen; i++)
+    h = (h ^ (unsigned char) sect[i]) * UINT64_C(1099511628211);
+  h *= UINT64_C(1099511628211); /* the \0 */
+  for (i = 0; i < nlen; i++)
+    h = (h ^ (unsigned char) name[i]) * UINT64_C(1099511628211);
+  h ^= h >> 33;
+  h *= UINT64_C(0xFF51AFD7ED558CCD);
+  h ^= h >> 33;
+  return h;
+}
+
+static uint32_t
+bucketof(uint64_t h, uint32_t nbuckets) { return (uint32_t) (h >> 32) % nbuckets; }
+
+static uint32_t
+slotof(uint64_t h, uint32_t d, uint32_t mask)
+{ /* h2 is odd, so d = 0..mask visits all slots */
+  uint32_t h1 = (uint32_t) h;
+  uint32_t h2 = (uint32_t) ((h * UINT64_C(0x9E3779B97F4A7C15)) >> 32) | 1;
+  return (h1 + d * h2) & mask;
+}
+
+/* Building */
+
+struct str { uint64_t hash; uint32_t ofs, len; };
+
+typedef struct {
+  uint32_t *slot;     /* 1 + index, or 0 if free */
+  size_t mask;
+  size_t count;
+} table_t;
+
+typedef struct {
+  strbuf strings;     /* interned strings, each \0 terminated */
+  struct str *strs;   /* buf.h: all interned strings */
+  table_t strtab;     /* index into strs by hash */
+  struct entry *entries;  /* buf.h */
+  uint64_t *keyhash;  /* buf.h: parallel to entries (seed 0) */
+  table_t keytab;     /* index into entries by hash */
+  int failed;
+} builder_t;
+
+static int
+regrow(table_t *tp, size_t n, const void *items, size_t stride)
+{ /* make room for n items (whose hash is their first member),
+     rehash if needed; return 0 if nomem */
+  uint32_t *slot;
+  size_t cap, i, j, mask;
+
+  if (2*n <= tp->mask + 1) return 1;
+
+  for (cap = 16; cap < 2*n; cap *= 2) {}
+  if (!(slot = calloc(cap, sizeof *slot))) return 0;
+  mask = cap - 1;
+
+  for (i = 0; i <= tp->mask && tp->slot; i++) {
+    uint32_t k = tp->slot[i];
+    if (!k) continue;
+    j = *(const uint64_t *) ((const char *) items + (k-1) * stride) & mask;
+    while (slot[j]) j = (j + 1) & mask;
+    slot[j] = k;
+  }
+
+  free(tp->slot);
+  tp->slot = slot;
+  tp->mask = mask;
+  return 1;
+}
+
+static uint32_t
+intern(builder_t *bp, const char *s, size_t len)
+{ /* return offset of string s[0..len) in string table */
+  const char *base;
+  struct str str;
+  uint64_t h;
+  size_t j;
+  uint32_t k;
+
+  h = hashkey(0, s, len, "", 0);
+
+  if (!regrow(&bp->strtab, bp->strtab.count + 1, bp->strs, sizeof *bp->strs))
+    goto nomem;
+
+  base = sbptr(&bp->strings);
+  for (j = h & bp->strtab.mask; (k = bp->strtab.slot[j]); j = (j + 1) & bp->strtab.mask) {
+    const struct str *sp = &bp->strs[k-1];
+    if (sp->hash == h && sp->len == len && memcmp(base + sp->ofs, s, len) == 0)
+      return sp->ofs;
+  }
+
+  str.hash = h;
+  str.ofs = (uint32_t) sblen(&bp->strings);
+  str.len = (uint32_t) len;
+  sbaddb(&bp->strings, s, len);
+  sbaddc(&bp->strings, '\0');
+  if (sbfailed(&bp->strings)) goto nomem;
+
+  buf_push(bp->strs, str);
+  bp->strtab.slot[j] = (uint32_t) buf_size(bp->strs);
+  bp->strtab.count++;
+  return str.ofs;
+
+nomem:
+  bp->failed = 1;
+  return 0;
+}
+
+static int
+ciequal(const char *s, const char *t)
+{ /* case insensitive comparison with lower case t */
+  while (*t && (*s | 0x20) == *t) s++, t++;
+  return !*s && !*t;
+}
+
+static void
+parsevalue(struct entry *ep, const char *s)
+{ /* parse value s as int, bool, duration */
+  static const struct { const char *unit; int64_t ms; } units[] = {
+    { "ms", 1 }, { "s", 1000 }, { "m", 60000 }, { "h", 3600000 }, { "d", 86400000 }
+  };
+  const char *p;
+  int64_t n, total;
+  int k, i;
+
+  ep->flags = 0;
+  ep->intval = ep->msecs = 0;
+
+  if ((k = scanint64(s, &n)) > 0 && !s[k]) {
+    ep->flags |= ISINT;
+    ep->intval = n;
+  }
+
+  if (ciequal(s, "true") || ciequal(s, "yes") || ciequal(s, "on") || !strcmp(s, "1"))
+    ep->flags |= ISBOOL | ISTRUE;
+  else if (ciequal(s, "false") || ciequal(s, "no") || ciequal(s, "off") || !strcmp(s, "0"))
+    ep->flags |= ISBOOL;
+
+  /* duration: one or more <digits><unit>, like 1h30m or 250ms, or 0 */
+  if (!strcmp(s, "0")) { ep->flags |= ISDUR; return; }
+  for (p = s, total = 0; *p; ) {
+    if (*p < '0' || *p > '9' || (k = scanint64(p, &n)) == 0) return;
+    p += k;
+    for (i = sizeof units / sizeof *units - 1; i >= 0; i--) {
+      size_t len = strlen(units[i].unit);
+      if (!strncmp(p, units[i].unit, len) && (p[len] < 'a' || p[len] > 'z')) break;
+    }
+    if (i < 0) return; /* no unit */
+    if (n > (INT64_MAX - total) / units[i].ms) return; /* overflow */
+    total += n * units[i].ms;
+    p += strlen(units[i].unit);
+  }
+  if (p > s) {
+    ep->flags |= ISDUR;
+    ep->msecs = total;
+  }
+}
+
+static int
+collect(iniconf_view sect, iniconf_view name, iniconf_view value, size_t lineno, void *userdata)
+{
+  builder_t *bp = (builder_t *) userdata;
+  struct entry e;
+  uint64_t h;
+  size_t j;
+  uint32_t k;
+
+  e.section = intern(bp, sect.ptr, sect.len);
+  e.name = intern(bp, name.ptr, name.len);
+  e.value = intern(bp, value.ptr, value.len);
+  e.lineno = (uint32_t) lineno;
+  e.unused = 0;
+  if (bp->failed) return -1;
+  parsevalue(&e, sbptr(&bp->strings) + e.value);
+
+  /* interned: same key iff same section and name offsets */
+  h = hashkey(0, sect.ptr, sect.len, name.ptr, name.len);
+  if (!regrow(&bp->keytab, bp->keytab.count + 1, bp->keyhash, sizeof *bp->keyhash))
+    goto nomem;
+  for (j = h & bp->keytab.mask; (k = bp->keytab.slot[j]); j = (j + 1) & bp->keytab.mask) {
+    struct entry *ep = &bp->entries[k-1];
+    if (ep->section == e.section && ep->name == e.name) {
+      *ep = e; /* the last one wins */
+      return 0;
+    }
+  }
+
+  buf_push(bp->entries, e);
+  buf_push(bp->keyhash, h);
+  bp->keytab.slot[j] = (uint32_t) buf_size(bp->entries);
+  bp->keytab.count++;
+  return 0;
+
+nomem:
+  bp->failed = 1;
+  return -1;
+}
+
+static int
+bybucketsize(const void *a, const void *b)
+{ /* sort buckets (size<<32|index) by decreasing size */
+  uint64_t x = *(const uint64_t *) a, y = *(const uint64_t *) b;
+  return x < y ? 1 : x > y ? -1 : 0;
+}
+
+static int
+perfect(const builder_t *bp, uint32_t seed, uint32_t nbuckets, uint32_t nslots,
+        uint32_t disp[], uint32_t slots[])
+{ /* find displacements for all buckets; return 0 if this seed fails */
+  uint32_t n = (uint32_t) buf_size(bp->entries);
+  uint32_t mask = nslots - 1;
+  uint64_t *order = 0, *hashes = 0;
+  uint32_t *start = 0, *keys = 0, *tmp = 0;
+  uint32_t i, b, d, k, m;
+  int ok = 0;
+
+  order = calloc(nbuckets, sizeof *order);
+  start = calloc(nbuckets + 1, sizeof *start);
+  keys = calloc(n + 1, sizeof *keys);
+  hashes = calloc(n + 1, sizeof *hashes);
+  tmp = calloc(n + 1, sizeof *tmp);
+  if (!order || !start || !keys || !hashes || !tmp) goto done;
+
+  /* group keys by bucket (counting sort) */
+  for (i = 0; i < n; i++) {
+    const struct entry *ep = &bp->entries[i];
+    const char *base = sbptr(&bp->strings);
+    const char *s = base + ep->section, *t = base + ep->name;
+    hashes[i] = hashkey(seed, s, strlen(s), t, strlen(t));
+    start[bucketof(hashes[i], nbuckets) + 1]++;
+  }
+  for (b = 0; b < nbuckets; b++) {
+    order[b] = (uint64_t) start[b+1] << 32 | b;
+    start[b+1] += start[b];
+  }
+  for (i = 0; i < n; i++) {
+    b = bucketof(hashes[i], nbuckets);
+    keys[start[b] + tmp[b]++] = i;
+  }
+  qsort(order, nbuckets, sizeof *order, bybucketsize);
+
+  for (i = 0; i < nslots; i++) slots[i] = NOENTRY;
+
+  for (i = 0; i < nbuckets; i++) {
+    uint32_t first, count;
+    b = (uint32_t) order[i];
+    first = start[b];
+    count = start[b+1] - first;
+    disp[b] = 0;
+    if (!count) continue;
+    for (d = 0; d < MAXTRIES; d++) {
+      for (k = 0; k < count; k++) {
+        uint32_t s = slotof(hashes[keys[first+k]], d, mask);
+        if (slots[s] != NOENTRY) break;
+        slots[s] = keys[first+k]; /* tentatively */
+      }
+      if (k == count) break; /* all placed */
+      for (m = 0; m < k; m++) /* undo */
+        slots[slotof(hashes[keys[first+m]], d, mask)] = NOENTRY;
+    }
+    if (d == MAXTRIES) goto done;
+    disp[b] = d;
+  }
+  ok = 1;
+
+done:
+  free(order);
+  free(start);
+  free(keys);
+  free(hashes);
+  free(tmp);
+  return ok;
+}
+
+static size_t
+align8(size_t n) { return (n + 7) & ~(size_t) 7; }
+
+static iniconf_store *
+build(builder_t *bp)
+{ /* assemble the store from the collected entries */
+  iniconf_store *sp;
+  uint32_t n = (uint32_t) buf_size(bp->entries);
+  uint32_t nbuckets = n / 4 + 1, nslots, seed;
+  size_t size, entries, disp, slots, strings;
+
+  for (nslots = 1; nslots < n + n/4; nslots *= 2) {}
+
+  entries = align8(sizeof *sp);
+  disp = entries + (size_t) n * sizeof (struct entry);
+  slots = disp + (size_t) nbuckets * sizeof (uint32_t);
+  strings = slots + (size_t) nslots * sizeof (uint32_t);
+  size = strings + sblen(&bp->strings);
+  if (size > UINT32_MAX) { errno = EFBIG; return 0; }
+
+  if (!(sp = malloc(size))) { errno = ENOMEM; return 0; }
+  memset(sp, 0, sizeof *sp);
+  sp->magic = MAGIC;
+  sp->size = (uint32_t) size;
+  sp->nentries = n;
+  sp->nbuckets = nbuckets;
+  sp->nslots = nslots;
+  sp->entries = (uint32_t) entries;
+  sp->disp = (uint32_t) disp;
+  sp->slots = (uint32_t) slots;
+  sp->strings = (uint32_t) strings;
+
+  for (seed = 0; seed < 16; seed++) {
+    if (perfect(bp, seed, nbuckets, nslots,
+                (uint32_t *) ((char *) sp + disp), (uint32_t *) ((char *) sp + slots)))
+      break;
+  }
+  if (seed == 16) { free(sp); errno = ENOMEM; return 0; }
+  sp->seed = seed;
+
+  if (n) memcpy((char *) sp + entries, bp->entries, (size_t) n * sizeof (struct entry));
+  memcpy((char *) sp + strings, sbptr(&bp->strings), sblen(&bp->strings));
+
+  return sp;
+}
+
+static void
+cleanup(builder_t *bp)
+{
+  sbfree(&bp->strings);
+  buf_free(bp->strs);
+  free(bp->strtab.slot);
+  buf_free(bp->entries);
+  buf_free(bp->keyhash);
+  free(bp->keytab.slot);
+}
+
+static iniconf_store *
+load(const char *fn, const char *buf, size_t len)
+{
+  builder_t builder;
+  iniconf_store *sp = 0;
+  int r, saverr;
+
+  memset(&builder, 0, sizeof builder);
+  sbaddc(&builder.strings, '\0'); /* offset 0 is never a string */
+
+  r = fn ? iniconf_map(fn, collect, &builder)
+         : iniconf_mem(buf, len, collect, &builder);
+  if (builder.failed) errno = ENOMEM;
+  if (r == 0 && !builder.failed) sp = build(&builder);
+
+  saverr = errno;
+  cleanup(&builder);
+  errno = saverr;
+  return sp;
+}
+
+/** Load the config file fn into a new store; return null on error */
+iniconf_store *
+iniconf_load(const char *fn)
+{
+  if (!fn) { errno = EINVAL; return 0; }
+  return load(fn, 0, 0);
+}
+
+/** Load the config in buf[0..len) into a new store */
+iniconf_store *
+iniconf_loadmem(const char *buf, size_t len)
+{
+  return load(0, buf ? buf : "", buf ? len : 0);
+}
+
+/* The cache file header */
+
+#define CACHEMAGIC 0x43494E49 /* "INIC" */
+#define CACHEVERSION 1
+#define CACHEHDR 64
+
+struct cachehdr {
+  uint32_t magic;     /* CACHEMAGIC, also tells byte order */
+  uint32_t version;   /* CACHEVERSION */
+  uint64_t srchash;   /* FNV-1a hash of the source file */
+  uint64_t srcsize;   /* size of the source file */
+  int64_t srcsec;     /* mtime of the source file, or 0 if */
+  int64_t srcnsec;    /* too recent to be trusted */
+  uint64_t storesize; /* size of the store that follows */
+  char unused[CACHEHDR - 2*4 - 5*8];
+};
+
+static int
+hashfile(const char *fn, const struct stat *sp, uint64_t *phash)
+{ /* hash the contents of file fn */
+  struct inifile file;
+  int fd, r;
+  if ((fd = open(fn, O_RDONLY)) < 0) return -1;
+  r = inifile_read(&file, fd, sp);
+  close(fd);
+  *phash = r == 0 ? inifile_hash(file.ptr, file.len) : 0;
+  inifile_free(&file);
+  return r;
+}
+
+static int
+writeall(int fd, const void *buf, size_t len)
+{
+  const char *p = buf;
+  ssize_t n;
+  while (len > 0) {
+    if ((n = write(fd, p, len)) < 0) {
+      if (errno == EINTR) continue;
+      return -1;
+    }
+    p += n;
+    len -= n;
+  }
+  return 0;
+}
+
+/** Compile config file inifn into the cache file cachefn
+ *  (written anew and renamed); return 0 or -1 on error */
+int
+iniconf_compile(const char *inifn, const char *cachefn)
+{
+  struct cachehdr hdr;
+  struct stat st;
+  iniconf_store *sp;
+  strbuf tmpfn = {0};
+  struct inifile file = {0};
+  int fd, r, saverr;
+
+  if (!inifn || !cachefn) { errno = EINVAL; return -1; }
+
+  if ((fd = open(inifn, O_RDONLY)) < 0) return -1;
+  r = fstat(fd, &st) < 0 ? -1 : inifile_read(&file, fd, &st);
+  saverr = errno;
+  close(fd);
+  errno = saverr;
+  if (r < 0) { inifile_free(&file); return -1; }
+
+  memset(&hdr, 0, sizeof hdr);
+  hdr.magic = CACHEMAGIC;
+  hdr.version = CACHEVERSION;
+  hdr.srchash = inifile_hash(file.ptr, file.len);
+  hdr.srcsize = file.len;
+  if (time(0) - st.st_mtim.tv_sec >= 2) { /* else: racy */
+    hdr.srcsec = st.st_mtim.tv_sec;
+    hdr.srcnsec = st.st_mtim.tv_nsec;
+  }
+
+  sp = iniconf_loadmem(file.ptr, file.len);
+  inifile_free(&file);
+  if (!sp) return -1;
+  hdr.storesize = sp->size;
+
+  /* write to a temporary file, then rename: readers see old or new */
+  sbaddf(&tmpfn, "%s.%ld.tmp", cachefn, (long) getpid());
+  if (sbfailed(&tmpfn)) { iniconf_free(sp); errno = ENOMEM; return -1; }
+  r = -1;
+  if ((fd = open(sbptr(&tmpfn), O_WRONLY | O_CREAT | O_TRUNC, 0644)) >= 0) {
+    if (writeall(fd, &hdr, sizeof hdr) == 0 && writeall(fd, sp, sp->size) == 0)
+      r = 0;
+    if (close(fd) < 0) r = -1;
+    if (r == 0) r = rename(sbptr(&tmpfn), cachefn);
+    if (r < 0) saverr = errno, unlink(sbptr(&tmpfn)), errno = saverr;
+  }
+
+  saverr = errno;
+  iniconf_free(sp);
+  sbfree(&tmpfn);
+  errno = saverr;
+  return r;
+}
+
+static int
+valid(const iniconf_store *sp, uint64_t size)
+{ /* check that the parts of the store lie within size bytes */
+  const uint64_t esize = sizeof (struct entry);
+  if (size < sizeof *sp || sp->magic != MAGIC || sp->size != size) return 0;
+  if (!sp->nslots || (sp->nslots & (sp->nslots - 1)) || !sp->nbuckets) return 0;
+  if (sp->entries < sizeof *sp || sp->entries % 8) return 0;
+  if (sp->entries + sp->nentries * esize > sp->disp) return 0;
+  if (sp->disp + sp->nbuckets * (uint64_t) 4 > sp->slots) return 0;
+  if (sp->slots + sp->nslots * (uint64_t) 4 > sp->strings) return 0;
+  if (sp->strings >= size || ((const char *) sp)[size-1] != '\0') return 0;
+  return 1;
+}
+
+static iniconf_store *
+mapcache(const char *cachefn, const char *inifn, const struct stat *src)
+{ /* map cache file if it is fresh, else return null */
+  const struct cachehdr *hp;
+  iniconf_store *sp;
+  struct stat st;
+  uint64_t hash;
+  char *map;
+  size_t size;
+  int fd;
+
+  if ((fd = open(cachefn, O_RDONLY)) < 0) return 0;
+  if (fstat(fd, &st) < 0 || (size = (size_t) st.st_size) < CACHEHDR) {
+    close(fd);
+    return 0;
+  }
+  /* private and writable, to set the flags (copy on write) */
+  map = mmap(0, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (map == MAP_FAILED) return 0;
+
+  hp = (const struct cachehdr *) map;
+  sp = (iniconf_store *) (map + CACHEHDR);
+  if (hp->magic != CACHEMAGIC || hp->version != CACHEVERSION ||
+      hp->storesize != size - CACHEHDR || hp->srcsize != (uint64_t) src->st_size)
+    goto stale;
+  if (hp->srcsec != src->st_mtim.tv_sec || hp->srcnsec != src->st_mtim.tv_nsec || !hp->srcsec) {
+    /* touched or racy: compare contents */
+    if (hashfile(inifn, src, &hash) < 0 || hash != hp->srchash) goto stale;
+  }
+  if (!valid(sp, hp->storesize)) goto stale;
+
+  sp->flags |= MAPPED;
+  return sp;
+
+stale:
+  munmap(map, size);
+  return 0;
+}
+
+/** Load the config file inifn from cache file cachefn if it
+ *  is fresh, else parse inifn (the cache file is not updated) */
+iniconf_store *
+iniconf_open(const char *inifn, const char *cachefn)
+{
+  struct stat src;
+  iniconf_store *sp;
+
+  if (!inifn) { errno = EINVAL; return 0; }
+  if (stat(inifn, &src) < 0) return 0;
+  if (cachefn && (sp = mapcache(cachefn, inifn, &src))) return sp;
+  return iniconf_load(inifn);
+}
+
+/** True if the store was mapped from a cache file */
+int
+iniconf_cached(const iniconf_store *sp)
+{
+  return sp && (sp->flags & MAPPED);
+}
+
+void
+iniconf_free(iniconf_store *sp)
+{
+  if (sp && (sp->flags & MAPPED))
+    munmap((char *) sp - CACHEHDR, CACHEHDR + sp->size);
+  else free(sp);
+}
+
+static const struct entry *
+lookup(const iniconf_store *sp, const char *section, const char *name)
+{ /* one hash, one probe, one comparison */
+  const char *strings;
+  const struct entry *ep;
+  size_t slen, nlen;
+  uint64_t h;
+  uint32_t d, i;
+
+  if (!sp || !sp->nentries || !name) return 0;
+  if (!section) section = "";
+
+  slen = strlen(section);
+  nlen = strlen(name);
+  h = hashkey(sp->seed, section, slen, name, nlen);
+  d = PART(sp, uint32_t, disp)[bucketof(h, sp->nbuckets)];
+  i = PART(sp, uint32_t, slots)[slotof(h, d, sp->nslots - 1)];
+  if (i >= sp->nentries) return 0; /* NOENTRY */
+
+  ep = PART(sp, struct entry, entries) + i;
+  strings = PART(sp, char, strings);
+  if (ep->name >= sp->size - sp->strings || ep->section >= sp->size - sp->strings ||
+      ep->value >= sp->size - sp->strings)
+    return 0; /* corrupt (strings end with \0) */
+  if (strcmp(strings + ep->name, name) || strcmp(strings + ep->section, section))
+    return 0;
+  return ep;
+}
+
+/** Number of distinct (section,name) entries in the store */
+size_t
+iniconf_count(const iniconf_store *sp)
+{
+  return sp ? sp->nentries : 0;
+}
+
+/** Value of name in section, or dflt if no such entry */
+const char *
+iniconf_get(const iniconf_store *sp, const char *section, const char *name, const char *dflt)
+{
+  const struct entry *ep = lookup(sp, section, name);
+  return ep ? PART(sp, char, strings) + ep->value : dflt;
+}
+
+/** Value as an integer, or dflt if no entry or not an integer */
+int64_t
+iniconf_getint(const iniconf_store *sp, const char *section, const char *name, int64_t dflt)
+{
+  const struct entry *ep = lookup(sp, section, name);
+  return ep && (ep->flags & ISINT) ? ep->intval : dflt;
+}
+
+/** Value as a boolean (true/false, yes/no, on/off, 1/0), or dflt */
+int
+iniconf_getbool(const iniconf_store *sp, const char *section, const char *name, int dflt)
+{
+  const struct entry *ep = lookup(sp, section, name);
+  return ep && (ep->flags & ISBOOL) ? (ep->flags & ISTRUE) != 0 : dflt;
+}
+
+/** Value as a duration (like 1h30m or 250ms) in milliseconds, or dflt */
+int64_t
+iniconf_getdur(const iniconf_store *sp, const char *section, const char *name, int64_t dflt)
+{
+  const struct entry *ep = lookup(sp, section, name);
+  return ep && (ep->flags & ISDUR) ? ep->msecs : dflt;
+}
+
+/** Line number where name in section was (last) defined, or 0 */
+size_t
+iniconf_lineno(const iniconf_store *sp, const char *section, const char *name)
+{
+  const struct entry *ep = lookup(sp, section, name);
+  return ep ? ep->lineno : 0;
+}
+
+#ifdef DEMO
+int main(int argc, char *argv[])
+{
+  iniconf_store *sp;
+  const char *value;
+  int i;
+
+  if (argc == 3) {
+    if (iniconf_compile(argv[1], argv[2]) == 0) return 0;
+    perror(argv[1]);
+    return 1;
+  }
+  if (argc < 5 || argc % 2 == 0) {
+    fprintf(stderr, "Usage: %s <file.ini> <cache>\n", argv[0]);
+    fprintf(stderr, "       %s <file.ini> <cache> {<section> <name>}\n", argv[0]);
+    fprintf(stderr, "Compile config file into cache file, or look up\n");
+    fprintf(stderr, "settings through the cache (if fresh)\n");
+    return 127;
+  }
+
+  if (!(sp = iniconf_open(argv[1], argv[2]))) {
+    perror(argv[1]);
+    return 1;
+  }
+  fprintf(stderr, "%s: %s\n", argv[1], iniconf_cached(sp) ? "cached" : "parsed");
+  for (i = 3; i + 1 < argc; i += 2) {
+    value = iniconf_get(sp, argv[i], argv[i+1], 0);
+    printf("[%s] %s = %s\n", argv[i], argv[i+1], value ? value : "(none)");
+  }
+  iniconf_free(sp);
+  return 0;
+}
+#endif
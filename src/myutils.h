@@ -22,12 +22,43 @@ size_t eatln(FILE *fp);
 #define ENDIAN_BIG     2    /* big endian: msb at lowest mem addr */
 int getendian(void); /* return one of the costants above */
 
+void *fastcopy(void *dst, const void *src, size_t n); /* like memcpy */
+
 #define UTCSTAMPLEN 20 /* #bytes in a UTCSTAMP */
+#define UTCSTAMPMAX 30 /* ditto, with nanoseconds */
+
+#include <stdint.h>
+
+struct utcclock {      /* cache for utcstampx, one per thread */
+  int64_t minute;      /* minutes since the epoch of stamp */
+  int second;          /* seconds in minute of stamp */
+  int valid;           /* zero-initialize to start empty */
+  char stamp[UTCSTAMPLEN];
+};
 
 size_t utcscan(const char *s, struct tm *tp);
+size_t utcscan_epoch(const char *s, size_t len, int64_t *secs, int32_t *nanos);
+size_t utcscan_epochv(const char *const s[], const size_t len[], size_t n,
+                      int64_t secs[], int32_t nanos[]);
+int64_t utcdays(int64_t year, int month, int day); /* since 1970-01-01 */
+int utcmdays(int64_t year, int month); /* days in month 1..12 */
 size_t utcstamp(char buf[], char sep);
+size_t utcstampx(struct utcclock *cp, char buf[], char sep, int digits);
+size_t utcformat(char buf[], int64_t secs, int32_t nanos, char sep, int digits);
 int utcinit(void);
 
+#define TAISTAMPLEN 25 /* #bytes in a TAI64N label */
+
+size_t taistamp(char buf[]);
+size_t taiformat(char buf[], int64_t secs, int32_t nanos);
+size_t taiscan(const char *s, int64_t *secs, int32_t *nanos);
+size_t taiformat_leaps(char buf[], int64_t secs, int32_t nanos); /* true TAI */
+size_t taiscan_leaps(const char *s, int64_t *secs, int32_t *nanos);
+size_t tai2utcv(const char *const tai[], size_t n, char *const utc[], char sep, int digits);
+size_t utc2taiv(const char *const utc[], const size_t len[], size_t n, char *const tai[]);
+int64_t utc2tai(int64_t secs); /* TAI seconds since 1970-01-01 TAI */
+int64_t tai2utc(int64_t tai);
+
 #define signum(x) (((x) > 0) - ((x) < 0))
 
 #endif
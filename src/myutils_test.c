@@ -4,6 +4,7 @@
 
 #include <assert.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <time.h>
 
@@ -23,6 +24,8 @@ myutils_test(int *pnumpass, int *pnumfail)
   char *line;
   size_t size;
   struct tm tm;
+  int64_t secs;
+  int32_t nanos;
 
   int numpass = 0;
   int numfail = 0;
@@ -130,10 +133,110 @@ myutils_test(int *pnumpass, int *pnumfail)
     tm.tm_hour == 12 && tm.tm_min == 34 && tm.tm_sec == 56);
   n = utcscan(" \t 1977-02-25 \t 12:34:56Z ", &tm);
   TEST("utscan padded", n == 25);
+  n = utcscan("2000-03-01T01:30:00+02:00", &tm);
+  TEST("utcscan offset", n == 25 && tm.tm_year == 100 && tm.tm_mon == 1 &&
+    tm.tm_mday == 29 && tm.tm_hour == 23 && tm.tm_min == 30);
+  n = utcscan("1999-12-31T20:15:00-0400", &tm);
+  TEST("utcscan negative offset", n == 24 && tm.tm_year == 100 &&
+    tm.tm_mon == 0 && tm.tm_mday == 1 && tm.tm_hour == 0 && tm.tm_min == 15);
+  n = utcscan_epoch("1977-02-25T12:34:56Z", 20, &secs, &nanos);
+  TEST("utcscan_epoch", n == 20 && secs == 225722096 && nanos == 0);
+  n = utcscan_epoch("2000-02-29 23:59:60.5Zx", 23, &secs, &nanos);
+  TEST("utcscan_epoch leap", n == 22 && secs == 951868800 && nanos == 500000000);
+  n = utcscan_epoch("1969-12-31T23:59:59.1234567890Z", 31, &secs, &nanos);
+  TEST("utcscan_epoch 1969", n == 31 && secs == -1 && nanos == 123456789);
+  TEST("utcscan_epoch bad day", utcscan_epoch("2001-02-29T00:00:00Z", 20, &secs, &nanos) == 0);
+  TEST("utcscan_epoch bad sep", utcscan_epoch("2001-02-28T00-00:00Z", 20, &secs, &nanos) == 0);
+  TEST("utcscan_epoch bad digit", utcscan_epoch("2001-02-2xT00:00:00Z", 20, &secs, &nanos) == 0);
+  n = utcscan_epoch("1977-02-25T14:34:56+02:00", 25, &secs, &nanos);
+  TEST("utcscan_epoch +02:00", n == 25 && secs == 225722096);
+  n = utcscan_epoch("1977-02-25T07:04:56.5-0530", 26, &secs, &nanos);
+  TEST("utcscan_epoch -0530", n == 26 && secs == 225722096 && nanos == 500000000);
+  TEST("utcscan_epoch bad zone", utcscan_epoch("2001-02-28T00:00:00+25:00", 25, &secs, &nanos) == 0);
+  TEST("utcscan_epoch cut zone", utcscan_epoch("2001-02-28T00:00:00+01:00", 20, &secs, &nanos) == 0);
+  TEST("utcscan_epoch short", utcscan_epoch("2001-02-28T00:00:00Z", 19, &secs, &nanos) == 0);
+  TEST("utcdays", utcdays(1970, 1, 1) == 0 && utcdays(2000, 3, 1) == 11017
+    && utcdays(1600, 1, 1) == -135140);
+  TEST("utcmdays", utcmdays(2000, 2) == 29 && utcmdays(1900, 2) == 28
+    && utcmdays(2023, 12) == 31 && utcmdays(2024, 4) == 30);
+  {
+    const char *col[] = { "1970-01-01T00:00:01Z", "oops", "2038-01-19T03:14:08.25Z" };
+    int64_t tv[3];
+    int32_t nv[3];
+    TEST("utcscan_epochv", utcscan_epochv(col, NULL, 3, tv, nv) == 2
+      && tv[0] == 1 && nv[0] == 0 && nv[1] == -1
+      && tv[2] == 2147483648 && nv[2] == 250000000);
+  }
   n = utcstamp(buf, 0);
   TEST("utcstamp", n == 20);
   buf[n] = 0;
   INFO("UTCSTAMP: %s", buf);
+  n = utcformat(buf, 225722096, 0, 0, 0);
+  buf[n] = 0;
+  TEST("utcformat", n == 20 && streq(buf, "1977-02-25T12:34:56Z"));
+  n = utcformat(buf, -1, 123456789, ' ', 6);
+  buf[n] = 0;
+  TEST("utcformat digits", n == 27 && streq(buf, "1969-12-31 23:59:59.123456Z"));
+  n = utcformat(buf, 951868800, 5, 0, 12);
+  buf[n] = 0;
+  TEST("utcformat nanos", n == 30 && streq(buf, "2000-03-01T00:00:00.000000005Z"));
+  {
+    struct utcclock clk = {0};
+    char buf2[UTCSTAMPMAX+1];
+    int64_t t1, t2;
+    n = utcstampx(&clk, buf2, 0, 3);
+    TEST("utcstampx", n == 24 && utcscan_epoch(buf2, n, &t1, &nanos) == (size_t) n);
+    n = utcstampx(&clk, buf2, ' ', 0);
+    TEST("utcstampx cached", n == 20 && utcscan_epoch(buf2, n, &t2, 0) == (size_t) n
+      && t2 >= t1 && t2 - t1 < 5);
+    buf2[n] = 0;
+    INFO("UTCSTAMPX: %s", buf2);
+  }
+
+  HEADING("Testing taistamp()/taiscan()");
+  TEST("utc2tai 1970", utc2tai(0) == 10 && tai2utc(10) == 0);
+  TEST("utc2tai 2017", utc2tai(1483228799) == 1483228799+36
+    && utc2tai(1483228800) == 1483228800+37);
+  TEST("tai2utc leap", tai2utc(1483228800+35) == 1483228799
+    && tai2utc(1483228800+36) == 1483228800
+    && tai2utc(1483228800+37) == 1483228800);
+  n = taiformat(buf, 0, 0);
+  buf[n] = 0;
+  TEST("taiformat epoch", n == TAISTAMPLEN && streq(buf, "@400000000000000a00000000"));
+  n = taiformat(buf, 1483228800, 123456789);
+  buf[n] = 0;
+  TEST("taiformat 2017", n == TAISTAMPLEN && streq(buf, "@400000005868468a075bcd15"));
+  n = taiformat(buf, 1700000000, 0);
+  buf[n] = 0;
+  TEST("taiformat as tai64n", n == TAISTAMPLEN && streq(buf, "@400000006553f10a00000000"));
+  n = taiformat_leaps(buf, 1483228800, 123456789);
+  buf[n] = 0;
+  TEST("taiformat_leaps 2017", n == TAISTAMPLEN && streq(buf, "@40000000586846a5075bcd15"));
+  n = taiscan("@400000005868468A075BCD15", &secs, &nanos);
+  TEST("taiscan", n == TAISTAMPLEN && secs == 1483228800 && nanos == 123456789);
+  n = taiscan_leaps("@40000000586846A5075BCD15", &secs, &nanos);
+  TEST("taiscan_leaps", n == TAISTAMPLEN && secs == 1483228800 && nanos == 123456789);
+  TEST("taiscan bad", taiscan("@40000000586846a5075bcd1", &secs, &nanos) == 0
+    && taiscan("40000000586846a5075bcd15", &secs, &nanos) == 0
+    && taiscan("@40000000586846a53b9aca00", &secs, &nanos) == 0
+    && taiscan_leaps("@40000000586846a53b9aca00", &secs, &nanos) == 0);
+  n = taiscan("@400000005868468a075bcd15" "0123456789abcdef0123456789abcdef", &secs, &nanos);
+  TEST("taiscan trailing hex", n == TAISTAMPLEN && secs == 1483228800 && nanos == 123456789);
+  {
+    const char *tais[] = { "@400000005868468a075bcd15", "@nonsense" };
+    const char *utcs[] = { "2017-01-01T00:00:00.123456789Z", "2017-01-01T01:00:00+01:00" };
+    char out1[UTCSTAMPMAX+1], out2[UTCSTAMPMAX+1];
+    char *outs[2];
+    outs[0] = out1; outs[1] = out2;
+    TEST("tai2utcv", tai2utcv(tais, 2, outs, 0, 3) == 1
+      && streq(out1, "2017-01-01T00:00:00.123Z") && out2[0] == 0);
+    TEST("utc2taiv", utc2taiv(utcs, NULL, 2, outs) == 2
+      && streq(out1, tais[0]) && streq(out2, "@400000005868468a00000000"));
+  }
+  n = taistamp(buf);
+  TEST("taistamp", n == TAISTAMPLEN && taiscan(buf, &secs, &nanos) == (size_t) n);
+  buf[n] = 0;
+  INFO("TAISTAMP: %s", buf);
 
   HEADING("Testing signum()");
   TEST("signum 42", signum(42) == 1);
@@ -143,6 +246,26 @@ myutils_test(int *pnumpass, int *pnumfail)
   TEST("signum -0.5", signum(-.5) == -1);
   TEST("signum 0.0", signum(0.0) == 0);
 
+  HEADING("Testing fastcopy()");
+  {
+    /* the last size takes the streaming store path (above 8M) */
+    size_t sizes[] = {0, 1, 31, 4096, 65536 + 77, (8UL << 20) + 4096 + 77};
+    size_t big = sizes[5] + 64, i, k;
+    unsigned char *src = malloc(big), *dst = malloc(big);
+    int ok = src && dst;
+    for (i = 0; ok && i < big; i++) src[i] = (unsigned char) (i * 31 + i / 251);
+    for (k = 0; ok && k < sizeof sizes / sizeof sizes[0]; k++) {
+      memset(dst, 0, big);
+      ok &= fastcopy(dst + 3, src + 5, sizes[k]) == dst + 3;
+      ok &= memcmp(dst + 3, src + 5, sizes[k]) == 0;
+      ok &= dst[2] == 0 && dst[3 + sizes[k]] == 0;
+    }
+    if (src && dst) TEST("fastcopy", ok);
+    else INFO("fastcopy: %s", "skipped, no memory (strbuf_test limits it with -s)");
+    free(src);
+    free(dst);
+  }
+
   *pnumpass += numpass;
   *pnumfail += numfail;
 }
@@ -0,0 +1,224 @@
+#include "scan.h"
+
+#include <stdlib.h>
+
+#include "buf.h"
+
+/* A set of scanpat() patterns, compiled into a trie.
+ *
+ * Each pattern is compiled into a sequence of tokens that mirrors
+ * what scanpat() does when interpreting the pattern: a literal char,
+ * a sequence of blanks (leading or not), or a star that skips up to
+ * the next pattern char. Since scanpat() never backtracks, each token
+ * advances the input position deterministically, and patterns with
+ * a common prefix of tokens share the work for that prefix.
+ *
+ * Matching simulates all patterns together, in one pass over the
+ * line, like an NFA: by the above, each trie node is reached at
+ * most once, at one position of the line. At each position, the nodes reached
+ * there try their child tokens: a literal child that matches the
+ * char is reached at the next position; a star child waits in a
+ * list for its stop char (or the end of the line), and a blank
+ * child waits for the first char that is not a blank or tab. So
+ * per input char, only the nodes waiting for that very char are
+ * touched, and the pass ends early once no node is alive. For
+ * the root, with typically many literal children, these are
+ * looked up in a table instead of searching the list.
+ */
+
+#define LIT 1   /* literal char c */
+#define BLANK 2 /* non-empty sequence of blanks and tabs */
+#define LEAD 3  /* possibly empty sequence of blanks and tabs */
+#define STAR 4  /* anything up to next c (or up to end if c is 0) */
+
+struct patnode {
+  int op, c;    /* the token */
+  int child;    /* first child node, or 0 */
+  int sibling;  /* next sibling node, or 0 */
+  int pat;      /* first pattern ending here, or -1 */
+};
+
+static int
+addnode(struct patset *ps, int parent, int op, int c)
+{ /* find or add child of parent with token op,c */
+  struct patnode node;
+  int i;
+
+  if (parent == 0 && op == LIT && ps->rootlit[c])
+    return ps->rootlit[c];
+
+  for (i = ps->nodes[parent].child; i; i = ps->nodes[i].sibling)
+    if (ps->nodes[i].op == op && ps->nodes[i].c == c) return i;
+
+  node.op = op;
+  node.c = c;
+  node.child = 0;
+  node.pat = -1;
+  i = (int) buf_size(ps->nodes);
+
+  if (parent == 0 && op == LIT) {
+    node.sibling = 0;
+    ps->rootlit[c] = i;
+  }
+  else {
+    node.sibling = ps->nodes[parent].child;
+    ps->nodes[parent].child = i;
+  }
+
+  buf_push(ps->nodes, node);
+  return i;
+}
+
+/** Compile pat and add it to the set; return its index */
+int
+patset_add(struct patset *ps, const char *pat)
+{
+  const char *pp;
+  int node, c, k;
+
+  if (!ps || !pat) return -1;
+
+  if (!ps->nodes) {
+    struct patnode root = { 0, 0, 0, 0, -1 };
+    buf_push(ps->nodes, root);
+  }
+
+  for (node = 0, pp = pat; ; ) {
+    c = (unsigned char) *pp++;
+    if (c == '\0') break;
+    if (c == ' ') {
+      node = addnode(ps, node, pp == pat+1 ? LEAD : BLANK, 0);
+      while (*pp == ' ' || *pp == '\t') ++pp;
+      continue;
+    }
+    if (c == '*') {
+      c = (unsigned char) *pp;
+      node = addnode(ps, node, STAR, c);
+      if (c == '\0') break;
+      continue;
+    }
+    node = addnode(ps, node, LIT, c);
+  }
+
+  k = ps->npats++;
+  buf_push(ps->next, ps->nodes[node].pat);
+  ps->nodes[node].pat = k;
+  return k;
+}
+
+#define NONE (-1)    /* end of a list of nodes */
+#define LOCALNODES 256  /* nodes with lists on the stack */
+#define ISBLANK(c) ((c) == ' ' || (c) == '\t')
+
+struct lists {       /* nodes reached or waiting, linked through link[] */
+  int *link;         /* next node in the same list */
+  int now;           /* reached at the current position */
+  int next;          /* reached at the next position (by a literal) */
+  int blanks;        /* waiting for the end of a run of blanks */
+  int stars[256];    /* waiting for their stop char (0: the end) */
+  int waiting;       /* #nodes in blanks and stars */
+};
+
+#define PUSH(ls, list, i) ((ls)->link[i] = (list), (list) = (i))
+
+static void
+reach(const struct patset *ps, struct lists *ls, int node, int ch)
+{ /* node was reached at the current position, where char ch is:
+     start its child tokens */
+  const struct patnode *np;
+  int i;
+
+  if (node == 0 && ch && (i = ps->rootlit[ch]))
+    PUSH(ls, ls->next, i);
+
+  for (i = ps->nodes[node].child; i; i = np->sibling) {
+    np = &ps->nodes[i];
+    switch (np->op) {
+      case LIT:
+        if (np->c == ch) PUSH(ls, ls->next, i);
+        break;
+      case BLANK:
+      case LEAD:
+        if (ISBLANK(ch)) { PUSH(ls, ls->blanks, i); ls->waiting++; }
+        else if (np->op == LEAD) PUSH(ls, ls->now, i);
+        break;
+      case STAR:
+        if (np->c == ch || ch == 0) PUSH(ls, ls->now, i);
+        else { PUSH(ls, ls->stars[np->c], i); ls->waiting++; }
+        break;
+    }
+  }
+}
+
+static void
+release(struct lists *ls, int *plist)
+{ /* the waiting nodes in *plist are reached now */
+  int i;
+  while ((i = *plist) != NONE) {
+    *plist = ls->link[i];
+    PUSH(ls, ls->now, i);
+    ls->waiting--;
+  }
+}
+
+/** Match s against all patterns in ps; store into counts[i] the
+ *  #bytes matched by the i-th pattern (0 if no match), return the
+ *  number of patterns that matched a non-empty prefix of s */
+int
+patset_match(const struct patset *ps, const char *s, int counts[])
+{
+  int local[LOCALNODES];
+  struct lists ls;
+  const char *q;
+  int ch, i, k, n = 0;
+  size_t nnodes;
+
+  if (!ps || !counts) return 0;
+  for (k = 0; k < ps->npats; k++) counts[k] = 0;
+  if (!s || !ps->nodes) return 0;
+
+  nnodes = buf_size(ps->nodes);
+  ls.link = nnodes <= LOCALNODES ? local : malloc(nnodes * sizeof *ls.link);
+  if (!ls.link) abort(); /* out of memory, like buf.h */
+  ls.now = 0; /* the root, reached at the start */
+  ls.link[0] = NONE;
+  ls.next = ls.blanks = NONE;
+  for (ch = 0; ch < 256; ch++) ls.stars[ch] = NONE;
+  ls.waiting = 0;
+
+  for (q = s; ; q++) {
+    ch = (unsigned char) *q;
+    if (ls.stars[ch] != NONE) release(&ls, &ls.stars[ch]);
+    if (ls.blanks != NONE && !ISBLANK(ch)) release(&ls, &ls.blanks);
+    if (ch == 0 && ls.waiting) /* the end stops all stars */
+      for (k = 1; k < 256; k++) release(&ls, &ls.stars[k]);
+
+    while ((i = ls.now) != NONE) {
+      ls.now = ls.link[i];
+      for (k = ps->nodes[i].pat; k >= 0; k = ps->next[k]) {
+        counts[k] = q - s;
+        if (q > s) n++;
+      }
+      reach(ps, &ls, i, ch);
+    }
+
+    if (ch == 0 || (ls.next == NONE && !ls.waiting)) break;
+    ls.now = ls.next; /* reached by a literal: at q+1 */
+    ls.next = NONE;
+  }
+
+  if (ls.link != local) free(ls.link);
+  return n;
+}
+
+/** Release memory, leaving an empty set */
+void
+patset_free(struct patset *ps)
+{
+  int c;
+  if (!ps) return;
+  buf_free(ps->nodes);
+  buf_free(ps->next);
+  for (c = 0; c < 256; c++) ps->rootlit[c] = 0;
+  ps->npats = 0;
+}
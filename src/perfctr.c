@@ -0,0 +1,170 @@
+/* required for syscall */
+#define _DEFAULT_SOURCE
+
+#include "perfctr.h"
+
+#include <errno.h>
+#include <string.h>
+
+/* The counters are opened as one group, with cycles as the group
+ * leader, so that they are counted over exactly the same time and
+ * can be read with a single read(2). Counting excludes the kernel
+ * and hypervisor, which also makes it work with the default
+ * perf_event_paranoid setting of 2. Counters that do not exist on
+ * the CPU (or in the virtual machine) are left out; if there are
+ * more counters than the PMU can count at once, the kernel
+ * multiplexes them, and we scale the counts by the fraction of the
+ * time they were counted.
+ *
+ * In containers, perf_event_open is often not permitted (seccomp,
+ * or perf_event_paranoid 3); perfctr_open then returns 0 and the
+ * caller carries on without counters.
+ */
+
+static const char *names[PERFCTR_MAX] = {
+  "cycles", "instructions", "branch-misses", "L1d-misses", "LLC-misses"
+};
+
+/** Name of counter which (PERFCTR_CYCLES etc.) */
+const char *
+perfctr_name(int which)
+{
+  return 0 <= which && which < PERFCTR_MAX ? names[which] : "?";
+}
+
+#if defined(__linux__)
+
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+static int
+openctr(int which, int leader)
+{
+  struct perf_event_attr attr;
+
+  memset(&attr, 0, sizeof attr);
+  attr.size = sizeof attr;
+  attr.type = PERF_TYPE_HARDWARE;
+  switch (which) {
+  case PERFCTR_CYCLES: attr.config = PERF_COUNT_HW_CPU_CYCLES; break;
+  case PERFCTR_INSTRUCTIONS: attr.config = PERF_COUNT_HW_INSTRUCTIONS; break;
+  case PERFCTR_BRANCHMISSES: attr.config = PERF_COUNT_HW_BRANCH_MISSES; break;
+  case PERFCTR_LLCMISSES: attr.config = PERF_COUNT_HW_CACHE_MISSES; break;
+  case PERFCTR_L1DMISSES:
+    attr.type = PERF_TYPE_HW_CACHE;
+    attr.config = PERF_COUNT_HW_CACHE_L1D |
+                  PERF_COUNT_HW_CACHE_OP_READ << 8 |
+                  PERF_COUNT_HW_CACHE_RESULT_MISS << 16;
+    break;
+  }
+  attr.disabled = leader < 0;  /* the group is enabled through its leader */
+  attr.exclude_kernel = 1;
+  attr.exclude_hv = 1;
+  attr.read_format = PERF_FORMAT_GROUP |
+                     PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+  return (int) syscall(SYS_perf_event_open, &attr, 0, -1, leader, 0);
+}
+
+/** Open the counters; return how many are available (0 if none,
+ *  with errno set, e.g. EACCES or ENOSYS in a container) */
+int
+perfctr_open(perfctr *pc)
+{
+  int i, leader;
+
+  memset(pc, 0, sizeof *pc);
+  for (i = 0; i < PERFCTR_MAX; i++) pc->fd[i] = -1;
+
+  leader = openctr(PERFCTR_CYCLES, -1);
+  if (leader < 0) return 0;
+  pc->fd[PERFCTR_CYCLES] = leader;
+  pc->order[pc->n++] = PERFCTR_CYCLES;
+
+  for (i = 0; i < PERFCTR_MAX; i++) {
+    if (i == PERFCTR_CYCLES) continue;
+    pc->fd[i] = openctr(i, leader);
+    if (pc->fd[i] >= 0) pc->order[pc->n++] = i;
+  }
+  return pc->n;
+}
+
+/** Reset and start the counters */
+int
+perfctr_start(perfctr *pc)
+{
+  int leader = pc->fd[PERFCTR_CYCLES];
+  if (leader < 0) { errno = EBADF; return -1; }
+  if (ioctl(leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP) < 0) return -1;
+  return ioctl(leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP) < 0 ? -1 : 0;
+}
+
+/** Stop the counters and store their counts in value[] */
+int
+perfctr_stop(perfctr *pc)
+{
+  uint64_t data[3 + PERFCTR_MAX]; /* nr, time enabled, time running, values */
+  int leader = pc->fd[PERFCTR_CYCLES], i;
+  double scale = 1;
+
+  memset(pc->value, 0, sizeof pc->value);
+  if (leader < 0) { errno = EBADF; return -1; }
+  if (ioctl(leader, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP) < 0) return -1;
+  if (read(leader, data, sizeof data) < (ssize_t) (3 * sizeof data[0])) return -1;
+
+  if (data[2] == 0) return 0; /* never scheduled: no counts */
+  if (data[2] < data[1]) scale = (double) data[1] / data[2];
+  for (i = 0; i < pc->n && (uint64_t) i < data[0]; i++)
+    pc->value[pc->order[i]] = (uint64_t) (data[3+i] * scale);
+  return 0;
+}
+
+/** Close the counters */
+void
+perfctr_close(perfctr *pc)
+{
+  int i;
+  for (i = 0; i < PERFCTR_MAX; i++) {
+    if (pc->fd[i] >= 0) close(pc->fd[i]);
+    pc->fd[i] = -1;
+  }
+  pc->n = 0;
+}
+
+#else /* not Linux */
+
+int
+perfctr_open(perfctr *pc)
+{
+  int i;
+  memset(pc, 0, sizeof *pc);
+  for (i = 0; i < PERFCTR_MAX; i++) pc->fd[i] = -1;
+  errno = ENOSYS;
+  return 0;
+}
+
+int
+perfctr_start(perfctr *pc)
+{
+  (void) pc;
+  errno = ENOSYS;
+  return -1;
+}
+
+int
+perfctr_stop(perfctr *pc)
+{
+  memset(pc->value, 0, sizeof pc->value);
+  errno = ENOSYS;
+  return -1;
+}
+
+void
+perfctr_close(perfctr *pc)
+{
+  pc->n = 0;
+}
+
+#endif
@@ -0,0 +1,29 @@
+#ifndef PERFCTR_H
+#define PERFCTR_H
+
+/* Hardware performance counters (Linux perf_event_open),
+ * counting in user mode for the calling thread only */
+
+#include <stdint.h>
+
+#define PERFCTR_CYCLES        0
+#define PERFCTR_INSTRUCTIONS  1
+#define PERFCTR_BRANCHMISSES  2
+#define PERFCTR_L1DMISSES     3  /* L1 data cache read misses */
+#define PERFCTR_LLCMISSES     4  /* last level cache misses */
+#define PERFCTR_MAX           5
+
+typedef struct perfctr {
+  int fd[PERFCTR_MAX];         /* -1 if this counter is not available */
+  int order[PERFCTR_MAX];      /* counters in group read order */
+  int n;                       /* number of counters opened */
+  uint64_t value[PERFCTR_MAX]; /* counts between start and stop */
+} perfctr;
+
+int perfctr_open(perfctr *pc);  /* #counters opened; 0 and errno if none */
+int perfctr_start(perfctr *pc); /* 0 or -1 on error */
+int perfctr_stop(perfctr *pc);  /* ditto; store the counts in value[] */
+void perfctr_close(perfctr *pc);
+const char *perfctr_name(int which);
+
+#endif
@@ -21,6 +21,7 @@ size_t printu(char *s, unsigned long val);
 size_t print0u(char *s, unsigned long val, int n);
 size_t printx(char *s, unsigned long val);
 size_t print0x(char *s, unsigned long val, int n);
+size_t hexencode(char *s, const void *buf, size_t n); /* 2n chars */
 
 size_t format(char *s, size_t n, const char *fmt, ...);
 size_t formatv(char *s, size_t n, const char *fmt, va_list ap);
@@ -12,6 +12,7 @@ print_test(int *pnumpass, int *pnumfail)
 {
   char buf[1024];
   char expected[1024];
+  char bytes[100], hex[256];
   char *p;
   size_t s;
 
@@ -60,11 +61,22 @@ print_test(int *pnumpass, int *pnumfail)
   print0(p);
   TEST("print0x()", STREQ("0000007B,0000ABCD,DEADBEEF", buf));
 
+  for (s = 0; s < 100; s++) bytes[s] = (char) (s * 37);
+  s = hexencode(hex, "\x01\x23\x45\x67\x89\xAB\xCD\xEF", 8);
+  hex[s] = 0;
+  TEST("hexencode()", s == 16 && STREQ("0123456789abcdef", hex));
+  s = hexencode(hex, bytes, 100);
+  hex[s] = 0;
+  TEST("hexencode() long", s == 200 && !strncmp(hex, "00254a6f94b9de03", 16)
+    && !strncmp(hex+64, "a0", 2) && !strncmp(hex+196, "2a4f", 4));
+  TEST("hexencode() null", hexencode(0, bytes, 5) == 10);
+
   p = buf;
   p += printd(p, -123);     p += printc(p, ',');
   p += printd(p, 0);        p += printc(p, ',');
   p += printd(p, LONG_MIN); p += printc(p, ',');
   p += printd(p, LONG_MAX);
+  print0(p);
   snprintf(expected, sizeof expected, "-123,0,%ld,%ld", LONG_MIN, LONG_MAX);
   TEST("printi()", STREQ(expected, buf));
 
@@ -85,6 +97,12 @@ print_test(int *pnumpass, int *pnumfail)
   s = format(buf, sizeof buf, "str=%s", (char *) 0);
   TEST("format null str", STREQ("str=(null)", buf) && s == 10);
 
+  s = format(buf, sizeof buf, "%x %u", 0xFFFFFFFFu, 4294967295u);
+  TEST("format unsigned int", STREQ("FFFFFFFF 4294967295", buf) && s == 19);
+
+  s = format(0, 0, "%s=%d", "abc", 42);
+  TEST("format null buf", s == 6);
+
   *pnumpass += numpass;
   *pnumfail += numfail;
 }
@@ -0,0 +1,487 @@
+#include "rand.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+/* Pseudo random numbers, each generator with its own state, so
+ * there is no hidden global state and no locking (unlike rand(3)).
+ *
+ * xoshiro256** (Blackman and Vigna, 2018) is the default: fast,
+ * passes all known statistical tests, and can jump ahead 2^128
+ * steps, which gives 2^128 non-overlapping streams for parallel
+ * use. It is seeded through SplitMix64, as its authors suggest.
+ *
+ * PCG64 (O'Neill, 2014) is a 128 bit LCG with a permuted output
+ * (xorshift high and low, random rotation); each odd increment
+ * gives a different stream, and it can advance by any distance
+ * in O(log distance) steps.
+ *
+ * wyrand (Wang Yi) adds a constant and mixes with one 64x64->128
+ * multiply; the fastest here, but with a period of only 2^64.
+ *
+ * Bounded integers use Lemire's method ("Fast Random Integer
+ * Generation in an Interval", 2019): the high half of x*n is in
+ * 0..n-1, and is unbiased if the low half is not below 2^64 mod n,
+ * which only needs a division in the rare case that it might be.
+ *
+ * rand_fill runs four xoshiro256** generators side by side, each
+ * seeded from the next output of the given one, and interleaves
+ * their outputs; with AVX2 it advances all four in one register
+ * set (64 bit multiplies by 5 and 9 are shifts and adds). The
+ * results are the same with or without AVX2, but differ from
+ * calling rand_next n times.
+ *
+ * For threads, each needs a state of its own: rand_split hands
+ * out states that are 2^128 apart (by jumping), and rand_stream
+ * makes the id-th stream of a seed in O(1) by starting SplitMix64
+ * at mix(seed) + 4*id*gamma; without the mix, (seed, id+1) would
+ * be (seed + 4*gamma, id) shifted, and the streams would overlap. Either way the result depends only on the seed and the
+ * index, not on which thread asks, so runs are reproducible.
+ */
+
+/* 64x64->128 bit multiply: return the low half, store the high */
+#if defined(__GNUC__) && defined(__SIZEOF_INT128__)
+__extension__ typedef unsigned __int128 uint128;
+static uint64_t
+mul128(uint64_t a, uint64_t b, uint64_t *phi)
+{
+  uint128 m = (uint128) a * b;
+  *phi = (uint64_t) (m >> 64);
+  return (uint64_t) m;
+}
+#else
+static uint64_t
+mul128(uint64_t a, uint64_t b, uint64_t *phi)
+{
+  uint64_t a0 = a & 0xFFFFFFFF, a1 = a >> 32;
+  uint64_t b0 = b & 0xFFFFFFFF, b1 = b >> 32;
+  uint64_t p00 = a0 * b0, p01 = a0 * b1, p10 = a1 * b0, p11 = a1 * b1;
+  uint64_t mid = (p00 >> 32) + (p01 & 0xFFFFFFFF) + (p10 & 0xFFFFFFFF);
+  *phi = p11 + (p01 >> 32) + (p10 >> 32) + (mid >> 32);
+  return (mid << 32) | (p00 & 0xFFFFFFFF);
+}
+#endif
+
+static uint64_t
+rotl(uint64_t x, int k)
+{
+  return (x << k) | (x >> (64 - k));
+}
+
+/** Next value of SplitMix64 with state *px */
+uint64_t
+splitmix64(uint64_t *px)
+{
+  uint64_t z = (*px += UINT64_C(0x9E3779B97F4A7C15));
+  z = (z ^ (z >> 30)) * UINT64_C(0xBF58476D1CE4E5B9);
+  z = (z ^ (z >> 27)) * UINT64_C(0x94D049BB133111EB);
+  return z ^ (z >> 31);
+}
+
+static uint64_t
+bounded(uint64_t (*next)(void *), void *state, uint64_t n)
+{ /* Lemire's nearly divisionless method */
+  uint64_t hi, lo, t;
+  if (n == 0) return 0;
+  lo = mul128(next(state), n, &hi);
+  if (lo < n) {
+    t = -n % n; /* 2^64 mod n */
+    while (lo < t) lo = mul128(next(state), n, &hi);
+  }
+  return hi;
+}
+
+/* xoshiro256** */
+
+/** Seed rs (all seeds are good ones) */
+void
+rand_seed(rand_state *rs, uint64_t seed)
+{
+  int i;
+  for (i = 0; i < 4; i++) rs->s[i] = splitmix64(&seed);
+}
+
+/** Next 64 random bits */
+uint64_t
+rand_next(rand_state *rs)
+{
+  uint64_t *s = rs->s;
+  uint64_t r = rotl(s[1] * 5, 7) * 9;
+  uint64_t t = s[1] << 17;
+  s[2] ^= s[0];
+  s[3] ^= s[1];
+  s[1] ^= s[2];
+  s[0] ^= s[3];
+  s[2] ^= t;
+  s[3] = rotl(s[3], 45);
+  return r;
+}
+
+static uint64_t
+next_xoshiro(void *state)
+{
+  return rand_next((rand_state *) state);
+}
+
+/** Unbiased random integer 0 <= r < n (0 if n is 0) */
+uint64_t
+rand_bounded(rand_state *rs, uint64_t n)
+{
+  return bounded(next_xoshiro, rs, n);
+}
+
+/** Unbiased random integer lo <= r <= hi */
+int64_t
+rand_range(rand_state *rs, int64_t lo, int64_t hi)
+{
+  uint64_t span = (uint64_t) hi - (uint64_t) lo;
+  if (hi < lo) return lo;
+  if (span == UINT64_MAX) return (int64_t) rand_next(rs);
+  return (int64_t) ((uint64_t) lo + rand_bounded(rs, span + 1));
+}
+
+/** Random double 0 <= r < 1 (53 random bits) */
+double
+rand_double(rand_state *rs)
+{
+  return (double) (rand_next(rs) >> 11) * 0x1.0p-53;
+}
+
+/** Advance rs by 2^128 steps: call it k times on a copy of a
+ *  state to get the k-th of 2^128 non-overlapping streams */
+void
+rand_jump(rand_state *rs)
+{
+  static const uint64_t jump[4] = {
+    UINT64_C(0x180EC6D33CFD0ABA), UINT64_C(0xD5A61266F0C9392C),
+    UINT64_C(0xA9582618E03FC9AA), UINT64_C(0x39ABDC4529B1661C)
+  };
+  uint64_t s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+  int i, b;
+
+  for (i = 0; i < 4; i++) {
+    for (b = 0; b < 64; b++) {
+      if (jump[i] & UINT64_C(1) << b) {
+        s0 ^= rs->s[0];
+        s1 ^= rs->s[1];
+        s2 ^= rs->s[2];
+        s3 ^= rs->s[3];
+      }
+      rand_next(rs);
+    }
+  }
+
+  rs->s[0] = s0;
+  rs->s[1] = s1;
+  rs->s[2] = s2;
+  rs->s[3] = s3;
+}
+
+/** Make n streams: streams[i] is rs jumped i times, and rs is
+ *  left jumped n times, so none of them overlap */
+void
+rand_split(rand_state *rs, rand_state streams[], size_t n)
+{
+  size_t i;
+  for (i = 0; i < n; i++) {
+    streams[i] = *rs;
+    rand_jump(rs);
+  }
+}
+
+/** Seed rs as the id-th stream of seed, for reproducible
+ *  results with any #threads */
+void
+rand_stream(rand_state *rs, uint64_t seed, uint64_t id)
+{
+  uint64_t x = splitmix64(&seed) + 4 * id * UINT64_C(0x9E3779B97F4A7C15);
+  int i;
+  for (i = 0; i < 4; i++) rs->s[i] = splitmix64(&x);
+}
+
+#define LANES 4
+
+static void
+fill4(uint64_t s[4][LANES], uint64_t *out, size_t nblocks)
+{ /* run LANES generators, interleaving their outputs */
+#if defined(__AVX2__)
+  __m256i s0 = _mm256_loadu_si256((const __m256i *) s[0]);
+  __m256i s1 = _mm256_loadu_si256((const __m256i *) s[1]);
+  __m256i s2 = _mm256_loadu_si256((const __m256i *) s[2]);
+  __m256i s3 = _mm256_loadu_si256((const __m256i *) s[3]);
+  __m256i r, t;
+  size_t i;
+
+  for (i = 0; i < nblocks; i++, out += LANES) {
+    r = _mm256_add_epi64(_mm256_slli_epi64(s1, 2), s1);              /* *5 */
+    r = _mm256_or_si256(_mm256_slli_epi64(r, 7), _mm256_srli_epi64(r, 57));
+    r = _mm256_add_epi64(_mm256_slli_epi64(r, 3), r);                /* *9 */
+    _mm256_storeu_si256((__m256i *) out, r);
+    t = _mm256_slli_epi64(s1, 17);
+    s2 = _mm256_xor_si256(s2, s0);
+    s3 = _mm256_xor_si256(s3, s1);
+    s1 = _mm256_xor_si256(s1, s2);
+    s0 = _mm256_xor_si256(s0, s3);
+    s2 = _mm256_xor_si256(s2, t);
+    s3 = _mm256_or_si256(_mm256_slli_epi64(s3, 45), _mm256_srli_epi64(s3, 19));
+  }
+
+  _mm256_storeu_si256((__m256i *) s[0], s0);
+  _mm256_storeu_si256((__m256i *) s[1], s1);
+  _mm256_storeu_si256((__m256i *) s[2], s2);
+  _mm256_storeu_si256((__m256i *) s[3], s3);
+#else
+  size_t i;
+  int k;
+
+  for (i = 0; i < nblocks; i++, out += LANES) {
+    for (k = 0; k < LANES; k++) {
+      uint64_t t = s[1][k] << 17;
+      out[k] = rotl(s[1][k] * 5, 7) * 9;
+      s[2][k] ^= s[0][k];
+      s[3][k] ^= s[1][k];
+      s[1][k] ^= s[2][k];
+      s[0][k] ^= s[3][k];
+      s[2][k] ^= t;
+      s[3][k] = rotl(s[3][k], 45);
+    }
+  }
+#endif
+}
+
+/** Store n random values into out[] (faster than rand_next for
+ *  large n, but not the same values) */
+void
+rand_fill(rand_state *rs, uint64_t *out, size_t n)
+{
+  uint64_t s[4][LANES], tail[LANES], x;
+  size_t i;
+  int j, k;
+
+  if (n < 4*LANES) {
+    for (i = 0; i < n; i++) out[i] = rand_next(rs);
+    return;
+  }
+
+  for (k = 0; k < LANES; k++) {
+    x = rand_next(rs);
+    for (j = 0; j < 4; j++) s[j][k] = splitmix64(&x);
+  }
+
+  fill4(s, out, n / LANES);
+  if (n % LANES) {
+    fill4(s, tail, 1);
+    for (i = 0; i < n % LANES; i++) out[n - n % LANES + i] = tail[i];
+  }
+}
+
+/* PCG64 */
+
+#define PCG_MULHI UINT64_C(2549297995355413924)
+#define PCG_MULLO UINT64_C(4865540595714422341)
+
+static void
+pcg_step(pcg64_state *ps)
+{ /* state = state * MUL + inc (mod 2^128) */
+  uint64_t hi, lo = mul128(ps->lo, PCG_MULLO, &hi);
+  hi += ps->hi * PCG_MULLO + ps->lo * PCG_MULHI;
+  ps->lo = lo + ps->inclo;
+  ps->hi = hi + ps->inchi + (ps->lo < lo);
+}
+
+/** Seed ps; each stream is a different sequence */
+void
+pcg64_seed(pcg64_state *ps, uint64_t seed, uint64_t stream)
+{
+  uint64_t lo;
+  ps->hi = ps->lo = 0;
+  ps->inchi = stream >> 63;
+  ps->inclo = stream << 1 | 1;
+  pcg_step(ps);
+  lo = ps->lo;
+  ps->lo += seed;
+  ps->hi += ps->lo < lo;
+  pcg_step(ps);
+}
+
+/** Next 64 random bits */
+uint64_t
+pcg64_next(pcg64_state *ps)
+{
+  uint64_t x;
+  int rot;
+  pcg_step(ps);
+  x = ps->hi ^ ps->lo;
+  rot = (int) (ps->hi >> 58);
+  return rot ? (x >> rot) | (x << (64 - rot)) : x;
+}
+
+static uint64_t
+next_pcg(void *state)
+{
+  return pcg64_next((pcg64_state *) state);
+}
+
+/** Unbiased random integer 0 <= r < n (0 if n is 0) */
+uint64_t
+pcg64_bounded(pcg64_state *ps, uint64_t n)
+{
+  return bounded(next_pcg, ps, n);
+}
+
+/** Advance ps by delta steps, in O(log delta) (Brown, 1994) */
+void
+pcg64_advance(pcg64_state *ps, uint64_t delta)
+{
+  uint64_t mulhi = PCG_MULHI, mullo = PCG_MULLO;
+  uint64_t plushi = ps->inchi, pluslo = ps->inclo;
+  uint64_t acchi = 0, acclo = 1, accplushi = 0, accpluslo = 0;
+  uint64_t hi, lo, t;
+
+  while (delta > 0) {
+    if (delta & 1) { /* acc = acc * mul, accplus = accplus * mul + plus */
+      lo = mul128(acclo, mullo, &hi);
+      acchi = hi + acchi * mullo + acclo * mulhi;
+      acclo = lo;
+      lo = mul128(accpluslo, mullo, &hi);
+      hi += accplushi * mullo + accpluslo * mulhi;
+      accpluslo = lo + pluslo;
+      accplushi = hi + plushi + (accpluslo < lo);
+    }
+    /* plus = (mul + 1) * plus, mul = mul * mul */
+    t = mullo + 1;
+    lo = mul128(pluslo, t, &hi);
+    plushi = hi + plushi * t + pluslo * (mulhi + (t < mullo));
+    pluslo = lo;
+    lo = mul128(mullo, mullo, &hi);
+    mulhi = hi + 2 * mullo * mulhi;
+    mullo = lo;
+    delta >>= 1;
+  }
+
+  /* state = acc * state + accplus */
+  lo = mul128(acclo, ps->lo, &hi);
+  hi += acchi * ps->lo + acclo * ps->hi;
+  ps->lo = lo + accpluslo;
+  ps->hi = hi + accplushi + (ps->lo < lo);
+}
+
+/* wyrand */
+
+/** Seed ws (all seeds are good ones) */
+void
+wyrand_seed(wyrand_state *ws, uint64_t seed)
+{
+  ws->s = seed;
+}
+
+/** Next 64 random bits */
+uint64_t
+wyrand_next(wyrand_state *ws)
+{
+  uint64_t hi, lo;
+  ws->s += UINT64_C(0xA0761D6478BD642F);
+  lo = mul128(ws->s, ws->s ^ UINT64_C(0xE7037ED1A0B428DB), &hi);
+  return hi ^ lo;
+}
+
+static uint64_t
+next_wyrand(void *state)
+{
+  return wyrand_next((wyrand_state *) state);
+}
+
+/** Unbiased random integer 0 <= r < n (0 if n is 0) */
+uint64_t
+wyrand_bounded(wyrand_state *ws, uint64_t n)
+{
+  return bounded(next_wyrand, ws, n);
+}
+
+#ifdef DEMO
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define FILLSIZE 4096
+
+/* the LCG from random.c (option -a), as a baseline */
+static unsigned long lcg = 1;
+static int
+lcgint(int limit)
+{
+  static unsigned a = 9301, c = 49297, m = 233280;
+  lcg = (lcg * a + c) % m;
+  return (limit*lcg)/m;
+}
+
+static void
+report(const char *name, clock_t start, long n, uint64_t sum)
+{
+  double secs = (double) (clock() - start) / CLOCKS_PER_SEC;
+  printf("%-24s %7.2f ns/number  (%016llx)\n", name, secs * 1e9 / n,
+    (unsigned long long) sum);
+}
+
+int main(int argc, char *argv[])
+{
+  long i, n = argc > 1 ? atol(argv[1]) : 10000000;
+  rand_state rs;
+  pcg64_state ps;
+  wyrand_state ws;
+  uint64_t sum, buf[FILLSIZE];
+  clock_t start;
+
+  if (argc > 2 || n <= 0) {
+    fprintf(stderr, "Usage: %s [N]\n", argv[0]);
+    fprintf(stderr, "Time N (default 10M) numbers from each generator\n");
+    return 127;
+  }
+
+  srand(1);
+  start = clock();
+  for (sum = 0, i = 0; i < n; i++) sum += rand();
+  report("rand(3)", start, n, sum);
+
+  start = clock();
+  for (sum = 0, i = 0; i < n; i++) sum += lcgint(RAND_MAX);
+  report("random -a (NR LCG)", start, n, sum);
+
+  rand_seed(&rs, 1);
+  start = clock();
+  for (sum = 0, i = 0; i < n; i++) sum += rand_next(&rs);
+  report("rand_next", start, n, sum);
+
+  pcg64_seed(&ps, 1, 0);
+  start = clock();
+  for (sum = 0, i = 0; i < n; i++) sum += pcg64_next(&ps);
+  report("pcg64_next", start, n, sum);
+
+  wyrand_seed(&ws, 1);
+  start = clock();
+  for (sum = 0, i = 0; i < n; i++) sum += wyrand_next(&ws);
+  report("wyrand_next", start, n, sum);
+
+  start = clock();
+  for (sum = 0, i = 0; i < n; i++) sum += rand() % 1000;
+  report("rand(3) % 1000", start, n, sum);
+
+  start = clock();
+  for (sum = 0, i = 0; i < n; i++) sum += lcgint(1000);
+  report("random -a, 0..999", start, n, sum);
+
+  start = clock();
+  for (sum = 0, i = 0; i < n; i++) sum += rand_bounded(&rs, 1000);
+  report("rand_bounded(1000)", start, n, sum);
+
+  start = clock();
+  for (sum = 0, i = 0; i < n; i += FILLSIZE) {
+    rand_fill(&rs, buf, FILLSIZE);
+    sum += buf[0];
+  }
+  report("rand_fill", start, i, sum);
+
+  return 0;
+}
+#endif
@@ -0,0 +1,64 @@
+/* Pseudo random number generators with per-instance state */
+
+#ifndef RAND_H
+#define RAND_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "strbuf.h"
+
+/* xoshiro256** (the default): period 2^256-1, jump ahead 2^128 */
+typedef struct rand_state { uint64_t s[4]; } rand_state;
+
+void rand_seed(rand_state *rs, uint64_t seed);
+uint64_t rand_next(rand_state *rs);
+uint64_t rand_bounded(rand_state *rs, uint64_t n);  /* 0 <= r < n */
+int64_t rand_range(rand_state *rs, int64_t lo, int64_t hi);  /* lo <= r <= hi */
+double rand_double(rand_state *rs);  /* 0 <= r < 1 */
+void rand_jump(rand_state *rs);
+void rand_split(rand_state *rs, rand_state streams[], size_t n);
+void rand_stream(rand_state *rs, uint64_t seed, uint64_t id);
+void rand_fill(rand_state *rs, uint64_t *out, size_t n);
+
+/* PCG64 (XSL-RR 128/64): 2^63 streams of period 2^128 */
+typedef struct pcg64_state { uint64_t hi, lo, inchi, inclo; } pcg64_state;
+
+void pcg64_seed(pcg64_state *ps, uint64_t seed, uint64_t stream);
+uint64_t pcg64_next(pcg64_state *ps);
+uint64_t pcg64_bounded(pcg64_state *ps, uint64_t n);
+void pcg64_advance(pcg64_state *ps, uint64_t delta);
+
+/* wyrand: the fastest, one multiply per number, period 2^64 */
+typedef struct wyrand_state { uint64_t s; } wyrand_state;
+
+void wyrand_seed(wyrand_state *ws, uint64_t seed);
+uint64_t wyrand_next(wyrand_state *ws);
+uint64_t wyrand_bounded(wyrand_state *ws, uint64_t n);
+
+/* SplitMix64: for seeding, or hashing a counter */
+uint64_t splitmix64(uint64_t *px);
+
+/* Sampling (with rand_state) */
+void rand_boundedv(rand_state *rs, uint64_t n, uint64_t out[], size_t m);
+void rand_shuffle(rand_state *rs, void *base, size_t n, size_t size);
+
+/* Reservoir sampling (Algorithm L): k items from a stream */
+typedef struct rand_reservoir { uint64_t k, seen, next; double w; } rand_reservoir;
+
+void rand_reservoir_init(rand_reservoir *rp, uint64_t k);
+long rand_reservoir_offer(rand_state *rs, rand_reservoir *rp);  /* slot or -1 */
+uint64_t rand_reservoir_gap(const rand_reservoir *rp);
+void rand_reservoir_skip(rand_reservoir *rp, uint64_t n);
+long rand_lines(rand_state *rs, FILE *fp, strbuf sample[], size_t k);
+
+/* Weighted sampling (Walker/Vose alias table): O(1) per draw */
+typedef struct rand_alias { size_t n; uint64_t *thresh; size_t *alias; } rand_alias;
+
+int rand_alias_init(rand_alias *ap, const double weights[], size_t n);
+size_t rand_alias_draw(rand_state *rs, const rand_alias *ap);
+void rand_alias_drawv(rand_state *rs, const rand_alias *ap, size_t out[], size_t m);
+void rand_alias_free(rand_alias *ap);
+
+#endif
@@ -0,0 +1,254 @@
+/* Unit tests for rand.h API */
+
+#include "test.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "myutils.h"
+#include "rand.h"
+
+static int
+uniform(rand_state *rs, uint64_t n, int draws)
+{ /* rough check: all counts of rand_bounded within 10% of expected */
+  int count[16] = {0};
+  int i, expected = draws / (int) n;
+  for (i = 0; i < draws; i++) {
+    uint64_t r = rand_bounded(rs, n);
+    if (r >= n) return 0;
+    count[r]++;
+  }
+  for (i = 0; i < (int) n; i++)
+    if (count[i] < expected * 9 / 10 || count[i] > expected * 11 / 10) return 0;
+  return 1;
+}
+
+void
+rand_test(int *pnumpass, int *pnumfail)
+{
+  int numpass = 0;
+  int numfail = 0;
+
+  rand_state rs = {{1, 2, 3, 4}}, rt;
+  pcg64_state ps, pt;
+  wyrand_state ws;
+  uint64_t buf[41], buf2[41];
+  int i, ok;
+
+  HEADING("Testing rand (xoshiro256**)");
+
+  TEST("next 1", rand_next(&rs) == 11520);
+  TEST("next 2", rand_next(&rs) == 0);
+  TEST("next 3", rand_next(&rs) == 1509978240);
+  TEST("next 4", rand_next(&rs) == UINT64_C(1215971899390074240));
+
+  rand_seed(&rs, 42);
+  TEST("seed", rand_next(&rs) == UINT64_C(0x15780b2e0c2ec716) &&
+       rand_next(&rs) == UINT64_C(0x6104d9866d113a7e));
+
+  rs.s[0] = 1, rs.s[1] = 2, rs.s[2] = 3, rs.s[3] = 4;
+  rand_jump(&rs);
+  TEST("jump", rs.s[0] == UINT64_C(0x8c7a153956b5f3d1) &&
+       rs.s[3] == UINT64_C(0x8386b786c4408050) &&
+       rand_next(&rs) == UINT64_C(0xbbd2f312298443d8));
+
+  {
+    rand_state streams[3], ru;
+    rand_seed(&rs, 7);
+    rt = rs;
+    rand_split(&rs, streams, 3);
+    ru = rt;
+    rand_jump(&ru);
+    TEST("split 1", rand_next(&streams[1]) == rand_next(&ru));
+    ru = rt;
+    rand_jump(&ru), rand_jump(&ru), rand_jump(&ru);
+    TEST("split rest", rand_next(&rs) == rand_next(&ru));
+    TEST("split 0", rand_next(&streams[0]) == rand_next(&rt));
+
+    rand_stream(&rs, 7, 1);
+    rand_stream(&rt, 7 + 4 * UINT64_C(0x9E3779B97F4A7C15), 0);
+    TEST("stream seeds", rs.s[0] != rt.s[0] && rs.s[1] != rt.s[0]);
+    rand_stream(&rs, 7, 1);
+    rand_stream(&ru, 7, 2);
+    rand_stream(&rt, 8, 1);
+    TEST("stream ids", rand_next(&rs) != rand_next(&ru) && rs.s[0] != rt.s[0]);
+    rand_stream(&ru, 7, 1);
+    rand_next(&ru);
+    TEST("stream repeat", rand_next(&rs) == rand_next(&ru));
+  }
+
+  rand_seed(&rs, 1);
+  TEST("bounded 0", rand_bounded(&rs, 0) == 0);
+  TEST("bounded 1", rand_bounded(&rs, 1) == 0);
+  TEST("bounded uniform 7", uniform(&rs, 7, 70000));
+  TEST("bounded uniform 16", uniform(&rs, 16, 160000));
+  for (ok = 1, i = 0; i < 1000; i++) {
+    uint64_t r = rand_bounded(&rs, UINT64_C(3) << 62);
+    if (r >= UINT64_C(3) << 62) ok = 0;
+  }
+  TEST("bounded large", ok);
+
+  for (ok = 1, i = 0; i < 1000; i++) {
+    int64_t r = rand_range(&rs, -3, 3);
+    if (r < -3 || r > 3) ok = 0;
+  }
+  TEST("range", ok);
+  TEST("range one", rand_range(&rs, 5, 5) == 5 && rand_range(&rs, 5, 4) == 5);
+  TEST("range full", rand_range(&rs, INT64_MIN, INT64_MAX) != rand_range(&rs, INT64_MIN, INT64_MAX));
+
+  for (ok = 1, i = 0; i < 1000; i++) {
+    double d = rand_double(&rs);
+    if (d < 0 || d >= 1) ok = 0;
+  }
+  TEST("double", ok);
+
+  rand_seed(&rs, 42);
+  rt = rs;
+  rand_fill(&rs, buf, 20);
+  TEST("fill", buf[0] == UINT64_C(0x8ee445d14631c453) &&
+       buf[1] == UINT64_C(0x9f62288718cc63b6) && buf[19] == UINT64_C(0x8c1a4d51eebb7380));
+  rs = rt;
+  rand_fill(&rs, buf, 41);
+  rs = rt;
+  rand_fill(&rs, buf2, 38);
+  for (ok = 1, i = 0; i < 38; i++) ok &= buf[i] == buf2[i];
+  TEST("fill tail", ok);
+  rs = rt;
+  rand_fill(&rs, buf, 5);
+  TEST("fill small", buf[0] == UINT64_C(0x15780b2e0c2ec716) &&
+       rand_next(&rt) == buf[0] && rand_next(&rt) == buf[1]);
+
+  HEADING("Testing pcg64");
+
+  pcg64_seed(&ps, 42, 54);
+  pt = ps;
+  TEST("pcg64 next", pcg64_next(&ps) == UINT64_C(0x86b1da1d72062b68) &&
+       pcg64_next(&ps) == UINT64_C(0x1304aa46c9853d39) &&
+       pcg64_next(&ps) == UINT64_C(0xa3670e9e0dd50358));
+  pcg64_advance(&pt, 1000);
+  TEST("pcg64 advance", pcg64_next(&pt) == UINT64_C(0xf771891bd1a77d13));
+  pcg64_seed(&ps, 42, 54);
+  pcg64_advance(&ps, 3);
+  pcg64_seed(&pt, 42, 54);
+  pcg64_next(&pt), pcg64_next(&pt), pcg64_next(&pt);
+  TEST("pcg64 advance 3", pcg64_next(&ps) == pcg64_next(&pt));
+  pcg64_seed(&pt, 42, 55);
+  TEST("pcg64 stream", pcg64_next(&ps) != pcg64_next(&pt));
+  for (ok = 1, i = 0; i < 1000; i++) ok &= pcg64_bounded(&ps, 10) < 10;
+  TEST("pcg64 bounded", ok);
+
+  HEADING("Testing wyrand");
+
+  wyrand_seed(&ws, 42);
+  TEST("wyrand next", wyrand_next(&ws) == UINT64_C(0xae4a7cbfdda9b434) &&
+       wyrand_next(&ws) == UINT64_C(0xe9cc09d33d38d9d2) &&
+       wyrand_next(&ws) == UINT64_C(0xcb5756512b93433a));
+  for (ok = 1, i = 0; i < 1000; i++) ok &= wyrand_bounded(&ws, 10) < 10;
+  TEST("wyrand bounded", ok);
+
+  HEADING("Testing sampling");
+
+  {
+    int a[100], seen[100], perm[6] = {0};
+    uint64_t v[1000];
+    size_t out[3000], k;
+    long slot;
+    rand_reservoir res;
+    rand_alias alias;
+    double weights[4] = {1, 0, 2, 5};
+    strbuf sample[5] = {{0}};
+    FILE *fp;
+
+    rand_seed(&rs, 3);
+    for (i = 0; i < 100; i++) a[i] = i, seen[i] = 0;
+    rand_shuffle(&rs, a, 100, sizeof *a);
+    for (k = 0, i = 0; i < 100; i++) seen[a[i]]++, k += a[i] != i;
+    for (ok = k > 50, i = 0; i < 100; i++) ok &= seen[i] == 1;
+    TEST("shuffle permutes", ok);
+    for (i = 0; i < 6000; i++) {
+      char c[3] = {0, 1, 2};
+      rand_shuffle(&rs, c, 3, 1);
+      perm[c[0]*2 + (c[1] > c[2])]++;
+    }
+    for (ok = 1, i = 0; i < 6; i++) ok &= perm[i] > 900 && perm[i] < 1100;
+    TEST("shuffle uniform", ok);
+    rand_shuffle(&rs, 0, 0, sizeof *a);
+    rand_shuffle(&rs, a, 1, sizeof *a);
+    TEST("shuffle empty", 1);
+
+    rand_boundedv(&rs, 7, v, 1000);
+    for (ok = 1, i = 0; i < 1000; i++) ok &= v[i] < 7;
+    TEST("boundedv", ok);
+    rand_boundedv(&rs, UINT64_C(3) << 62, v, 1000);
+    for (ok = 1, i = 0; i < 1000; i++) ok &= v[i] < UINT64_C(3) << 62;
+    TEST("boundedv large", ok);
+
+    rand_reservoir_init(&res, 10);
+    for (ok = 1, i = 0; i < 5; i++) ok &= rand_reservoir_offer(&rs, &res) == i;
+    TEST("reservoir fill", ok && rand_reservoir_gap(&res) == 0);
+    for (i = 0; i < 10; i++) seen[i] = 0;
+    for (k = 0; k < 10000; k++) { /* 10 of 1000 items: 1 per 100 on average */
+      int item[10];
+      uint64_t gap;
+      rand_reservoir_init(&res, 10);
+      for (i = 0; i < 1000; i++) {
+        if ((gap = rand_reservoir_gap(&res)) > 0) {
+          if (gap > (uint64_t) (999 - i)) break;
+          rand_reservoir_skip(&res, gap);
+          i += (int) gap;
+        }
+        slot = rand_reservoir_offer(&rs, &res);
+        if (slot >= 0) item[slot] = i;
+      }
+      for (i = 0; i < 10; i++) seen[item[i] / 100]++;
+    }
+    for (ok = 1, i = 0; i < 10; i++) ok &= seen[i] > 9000 && seen[i] < 11000;
+    TEST("reservoir uniform", ok);
+    rand_reservoir_init(&res, 0);
+    TEST("reservoir 0", rand_reservoir_offer(&rs, &res) == -1);
+
+    fp = tmpfile();
+    for (i = 0; i < 1000; i++) fprintf(fp, "%d\n", i);
+    rewind(fp);
+    TEST("lines", rand_lines(&rs, fp, sample, 5) == 5);
+    for (ok = 1, i = 0; i < 5; i++) {
+      int j, n = atoi(sbptr(&sample[i]));
+      ok &= sblen(&sample[i]) > 1 && n >= 0 && n < 1000;
+      for (j = 0; j < i; j++) ok &= n != atoi(sbptr(&sample[j]));
+    }
+    TEST("lines distinct", ok);
+    fclose(fp);
+    fp = tmpfile();
+    fputs("a\nb", fp);
+    rewind(fp);
+    TEST("lines fewer", rand_lines(&rs, fp, sample, 5) == 2 &&
+         ((streq(sbptr(&sample[0]), "a\n") && streq(sbptr(&sample[1]), "b")) ||
+          (streq(sbptr(&sample[0]), "b") && streq(sbptr(&sample[1]), "a\n"))));
+    fclose(fp);
+    for (i = 0; i < 5; i++) sbfree(&sample[i]);
+
+    TEST("alias init", rand_alias_init(&alias, weights, 4) == 0);
+    for (i = 0; i < 4; i++) seen[i] = 0;
+    for (i = 0; i < 8000; i++) seen[rand_alias_draw(&rs, &alias)]++;
+    TEST("alias draw", seen[1] == 0 && seen[0] > 800 && seen[0] < 1200 &&
+         seen[2] > 1700 && seen[2] < 2300 && seen[3] > 4600 && seen[3] < 5400);
+    for (i = 0; i < 4; i++) seen[i] = 0;
+    rand_alias_drawv(&rs, &alias, out, 3000);
+    for (k = 0; k < 3000; k++) seen[out[k]]++;
+    TEST("alias drawv", seen[1] == 0 && seen[0] > 300 && seen[0] < 450 &&
+         seen[2] > 650 && seen[2] < 850 && seen[3] > 1700 && seen[3] < 2050);
+    rand_alias_free(&alias);
+    weights[0] = weights[2] = weights[3] = 0;
+    TEST("alias zero", rand_alias_init(&alias, weights, 4) == -1);
+    weights[1] = -1;
+    TEST("alias negative", rand_alias_init(&alias, weights, 4) == -1);
+    weights[1] = 3;
+    TEST("alias one", rand_alias_init(&alias, weights, 4) == 0 &&
+         rand_alias_draw(&rs, &alias) == 1 && rand_alias_draw(&rs, &alias) == 1);
+    rand_alias_free(&alias);
+  }
+
+  *pnumpass += numpass;
+  *pnumfail += numfail;
+}
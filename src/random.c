@@ -1,11 +1,18 @@
 /* Print random numbers from rand(3) */
-/* Usage: random [-a] [N [seed]] */
+/* Usage: random [-a | -t threads] [N [seed]] */
+
+/* required for pthreads */
+#define _POSIX_C_SOURCE 200112L
 
 #include <limits.h>
+#include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+#include "print.h"
+#include "rand.h"
+
 /* Pseudo random numbers:
 
   The standard library provides rand(3) and srand(3).
@@ -18,7 +25,15 @@
 
   The 3rd edition of NR says linear congruential generators
   are a relict from the past, new better methods exist.
-  May investigate some day...
+  See rand.h for some of them.
+
+  Option -t uses xoshiro256** from rand.h on the given number
+  of threads. The numbers come in blocks of BLOCK, and block b
+  is drawn from stream b of the seed (see rand_stream), so the
+  output depends on N and the seed only, not on the number of
+  threads. Each thread formats its blocks into a buffer of its
+  own (no shared state in the loop); the main thread writes the
+  buffers in order, round after round.
 */
 
 static unsigned long r = 1; /* 0 <= r < m */
@@ -30,6 +45,77 @@ int randint(int limit) {
   // return lo + ((hi-lo+1)*r)/m; /* lo <= r <= hi */
 }
 
+#define BLOCK 4096       /* numbers per stream */
+#define ROUND 64         /* blocks per thread and round */
+#define MAXTHREADS 256
+#define MAXLEN 11        /* digits of RAND_MAX and newline */
+#if RAND_MAX > 2147483647
+#error "MAXLEN too small for RAND_MAX"
+#endif
+
+struct job {
+  uint64_t seed;
+  long first, count;     /* numbers first .. first+count-1 */
+  char *out;             /* formatted numbers */
+  size_t len;
+  pthread_t thread;
+};
+
+static void *
+generate(void *arg)
+{ /* format numbers first.. into out; first is a block start */
+  struct job *jp = (struct job *) arg;
+  long i = jp->first, end = jp->first + jp->count, stop;
+  char *p = jp->out;
+  rand_state rs;
+
+  while (i < end) {
+    rand_stream(&rs, jp->seed, (uint64_t) (i / BLOCK));
+    stop = (i / BLOCK + 1) * BLOCK;
+    if (stop > end) stop = end;
+    for (; i < stop; i++) {
+      p += printu(p, (unsigned long) rand_bounded(&rs, (uint64_t) RAND_MAX + 1));
+      *p++ = '\n';
+    }
+  }
+
+  jp->len = p - jp->out;
+  return 0;
+}
+
+static int
+parallel(long n, unsigned seed, int nthreads)
+{ /* print n numbers, generated on nthreads threads */
+  struct job *jobs;
+  long done, first;
+  int t, started[MAXTHREADS], r = 0;
+
+  if (!(jobs = calloc(nthreads, sizeof *jobs))) return 1;
+  for (t = 0; t < nthreads; t++) {
+    jobs[t].seed = seed;
+    if (!(jobs[t].out = malloc((size_t) ROUND * BLOCK * MAXLEN))) r = 1;
+  }
+
+  for (done = 0; r == 0 && done < n; done += (long) nthreads * ROUND * BLOCK) {
+    for (t = 0; t < nthreads; t++) {
+      first = done + (long) t * ROUND * BLOCK;
+      jobs[t].first = first;
+      jobs[t].count = first >= n ? 0 : n - first < ROUND * BLOCK ? n - first : ROUND * BLOCK;
+      started[t] = jobs[t].count > 0 &&
+                   pthread_create(&jobs[t].thread, 0, generate, &jobs[t]) == 0;
+      if (!started[t]) generate(&jobs[t]);
+    }
+    for (t = 0; t < nthreads; t++) {
+      if (started[t]) pthread_join(jobs[t].thread, 0);
+      if (fwrite(jobs[t].out, 1, jobs[t].len, stdout) != jobs[t].len) r = 1;
+    }
+  }
+
+  for (t = 0; t < nthreads; t++) free(jobs[t].out);
+  free(jobs);
+  return r;
+}
+
 typedef int randfun(void);
 typedef void seedfun(unsigned);
 static int randalt(void) { return randint(RAND_MAX); }
@@ -43,6 +129,7 @@ int main(int argc, char **argv)
   unsigned seed;
   int i, n = 5;
   int show = 0;
+  int nthreads = 0;
   const char *me = "random";
 
   randfun *rf = rand;
@@ -58,6 +145,15 @@ int main(int argc, char **argv)
     argc--;
     argv++;
   }
+  else if (argc > 2 && argv && !strcmp(argv[1], "-t")) {
+    nthreads = atoi(argv[2]);
+    if (nthreads < 1 || nthreads > MAXTHREADS) {
+      fprintf(stderr, "Error: threads out of range 1..%d\n", MAXTHREADS);
+      return 1;
+    }
+    argc -= 2;
+    argv += 2;
+  }
 
   switch (argc) {
     case 3:
@@ -74,9 +170,11 @@ int main(int argc, char **argv)
     case 1:
       break;
     default:
-      fprintf(stderr, "Usage: %s [-a] [N [seed]]\n", me);
+      fprintf(stderr, "Usage: %s [-a | -t threads] [N [seed]]\n", me);
       fprintf(stderr, "Print N (default: %d) results from rand(3)\n", default_count);
       fprintf(stderr, "Option -a selects an alternative LCG (see source)\n");
+      fprintf(stderr, "Option -t selects xoshiro256** streams on threads,\n");
+      fprintf(stderr, "with the same output for any number of threads\n");
       return 1;
   }
 
@@ -87,6 +185,10 @@ int main(int argc, char **argv)
       n, seed, RAND_MAX);
   }
 
+  if (nthreads > 0) {
+    return parallel(n, seed, nthreads);
+  }
+
   sf(seed);
 
   for (i = 0; i < n; i++) {
@@ -0,0 +1,305 @@
+#include "rand.h"
+#include "myutils.h"
+
+#include <errno.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Random sampling on top of rand.h
+ *
+ * Shuffling is Fisher-Yates (Durstenfeld's in-place version).
+ *
+ * Reservoir sampling uses Li's Algorithm L (1994): instead of a
+ * random number for every item (Algorithm R), it draws how many
+ * items to skip until the next one to keep, which is geometric;
+ * the number of draws is O(k (1 + log(N/k))) for N items. Skipped
+ * lines are read with eatln, without storing them.
+ *
+ * Weighted sampling uses Walker's alias method with Vose's stable
+ * construction: each of n columns holds a threshold and an alias,
+ * and a draw picks a column and returns it or its alias. A single
+ * 64 bit random x does both: the high half of x*n is the column,
+ * the low half (the fraction) is compared with the threshold. The
+ * column is biased by at most n/2^64, which is negligible.
+ *
+ * The batch functions get their random numbers from rand_fill.
+ */
+
+#define BATCH 256
+
+/* 64x64->128 bit multiply: return the low half, store the high */
+#if defined(__GNUC__) && defined(__SIZEOF_INT128__)
+__extension__ typedef unsigned __int128 uint128;
+static uint64_t
+mul128(uint64_t a, uint64_t b, uint64_t *phi)
+{
+  uint128 m = (uint128) a * b;
+  *phi = (uint64_t) (m >> 64);
+  return (uint64_t) m;
+}
+#else
+static uint64_t
+mul128(uint64_t a, uint64_t b, uint64_t *phi)
+{
+  uint64_t a0 = a & 0xFFFFFFFF, a1 = a >> 32;
+  uint64_t b0 = b & 0xFFFFFFFF, b1 = b >> 32;
+  uint64_t p00 = a0 * b0, p01 = a0 * b1, p10 = a1 * b0, p11 = a1 * b1;
+  uint64_t mid = (p00 >> 32) + (p01 & 0xFFFFFFFF) + (p10 & 0xFFFFFFFF);
+  *phi = p11 + (p01 >> 32) + (p10 >> 32) + (mid >> 32);
+  return (mid << 32) | (p00 & 0xFFFFFFFF);
+}
+#endif
+
+/** Store m unbiased random integers 0 <= r < n into out[] */
+void
+rand_boundedv(rand_state *rs, uint64_t n, uint64_t out[], size_t m)
+{
+  uint64_t buf[BATCH], hi, lo, t = n ? -n % n : 0;
+  size_t i, j, c;
+
+  for (i = 0; i < m; i += c) {
+    c = m - i < BATCH ? m - i : BATCH;
+    rand_fill(rs, buf, c);
+    for (j = 0; j < c; j++) {
+      lo = mul128(buf[j], n, &hi);
+      while (lo < t) lo = mul128(rand_next(rs), n, &hi); /* rare */
+      out[i+j] = hi;
+    }
+  }
+}
+
+/* Shuffle */
+
+static void
+swap(unsigned char *a, unsigned char *b, size_t size)
+{
+  unsigned char tmp[64];
+  size_t k;
+
+  if (size == sizeof (uint64_t)) {
+    uint64_t t;
+    memcpy(&t, a, sizeof t);
+    memcpy(a, b, sizeof t);
+    memcpy(b, &t, sizeof t);
+    return;
+  }
+  for (; size > 0; size -= k, a += k, b += k) {
+    k = size < sizeof tmp ? size : sizeof tmp;
+    memcpy(tmp, a, k);
+    memcpy(a, b, k);
+    memcpy(b, tmp, k);
+  }
+}
+
+/** Shuffle the n elements of size bytes at base (like qsort),
+ *  all n! orders equally likely */
+void
+rand_shuffle(rand_state *rs, void *base, size_t n, size_t size)
+{
+  unsigned char *p = (unsigned char *) base;
+  size_t i, j;
+
+  if (!p || size == 0) return;
+  for (i = n; i > 1; i--) {
+    j = (size_t) rand_bounded(rs, i);
+    if (j != i-1) swap(p + (i-1) * size, p + j * size, size);
+  }
+}
+
+/* Reservoir */
+
+static double
+uniform(rand_state *rs)
+{ /* 0 < u < 1 */
+  return ((double) (rand_next(rs) >> 11) + 0.5) * 0x1.0p-53;
+}
+
+static void
+advance(rand_state *rs, rand_reservoir *rp, uint64_t i)
+{ /* item i was kept: draw the next one to keep */
+  double skip;
+  rp->w *= exp(log(uniform(rs)) / (double) rp->k);
+  skip = floor(log(uniform(rs)) / log1p(-rp->w));
+  rp->next = skip < 0x1.0p63 ? i + 1 + (uint64_t) skip : UINT64_MAX;
+  if (rp->next <= i) rp->next = UINT64_MAX; /* overflow */
+}
+
+/** Start sampling k items from a stream of unknown length */
+void
+rand_reservoir_init(rand_reservoir *rp, uint64_t k)
+{
+  rp->k = k;
+  rp->seen = 0;
+  rp->next = 0;
+  rp->w = 1;
+}
+
+/** Offer the next item: return the slot 0..k-1 to put it in
+ *  (replacing what was there), or -1 if it is not kept */
+long
+rand_reservoir_offer(rand_state *rs, rand_reservoir *rp)
+{
+  uint64_t i = rp->seen++;
+  long slot;
+
+  if (i < rp->k) { /* fill the reservoir */
+    if (i + 1 == rp->k) advance(rs, rp, i);
+    return (long) i;
+  }
+  if (rp->k == 0 || i < rp->next) return -1;
+
+  slot = (long) rand_bounded(rs, rp->k);
+  advance(rs, rp, i);
+  return slot;
+}
+
+/** Number of items that rand_reservoir_offer will drop before it keeps
+ *  one; the caller may skip them with rand_reservoir_skip */
+uint64_t
+rand_reservoir_gap(const rand_reservoir *rp)
+{
+  if (rp->k == 0) return UINT64_MAX;
+  if (rp->seen < rp->k) return 0;
+  return rp->next - rp->seen;
+}
+
+/** Drop the next n items (at most the gap) without offering them */
+void
+rand_reservoir_skip(rand_reservoir *rp, uint64_t n)
+{
+  rp->seen += n;
+}
+
+/** Read all lines from fp and keep k random ones in sample[0..k),
+ *  each line equally likely; return #kept (less than k only if
+ *  there are fewer lines), or -1 on error */
+long
+rand_lines(rand_state *rs, FILE *fp, strbuf sample[], size_t k)
+{
+  rand_reservoir res;
+  strbuf line = {0}, tmp;
+  uint64_t gap;
+  long n = 0, slot;
+
+  if (!fp || (k > 0 && !sample)) { errno = EINVAL; return -1; }
+  if (k == 0) return 0;
+
+  rand_reservoir_init(&res, k);
+  for (;;) {
+    for (gap = rand_reservoir_gap(&res); gap > 0; gap--) {
+      if (eatln(fp) == 0) goto done;
+      rand_reservoir_skip(&res, 1);
+    }
+    if ((n = getln(fp, &line, 0)) <= 0) break;
+    slot = rand_reservoir_offer(rs, &res);
+    tmp = sample[slot];
+    sample[slot] = line;
+    line = tmp;
+  }
+
+done:
+  sbfree(&line);
+  if (n < 0 || ferror(fp)) return -1;
+  return (long) (res.seen < k ? res.seen : k);
+}
+
+/* Alias table */
+
+/** Build an alias table for indices 0..n-1 with the given
+ *  weights (non-negative, not all 0); return 0 or -1 on error */
+int
+rand_alias_init(rand_alias *ap, const double weights[], size_t n)
+{
+  double sum = 0, *p;
+  size_t *work, nsmall = 0, nlarge = 0, i, s, l;
+
+  memset(ap, 0, sizeof *ap);
+  if (!weights || n == 0) { errno = EINVAL; return -1; }
+  for (i = 0; i < n; i++) {
+    if (!(weights[i] >= 0) || weights[i] > 1e300) { errno = EINVAL; return -1; }
+    sum += weights[i];
+  }
+  if (!(sum > 0) || sum > 1e300) { errno = EINVAL; return -1; }
+
+  ap->thresh = malloc(n * sizeof *ap->thresh);
+  ap->alias = malloc(n * sizeof *ap->alias);
+  p = malloc(n * sizeof *p);
+  work = malloc(n * sizeof *work); /* small from the front, large from the back */
+  if (!ap->thresh || !ap->alias || !p || !work) {
+    free(p);
+    free(work);
+    rand_alias_free(ap);
+    errno = ENOMEM;
+    return -1;
+  }
+
+  for (i = 0; i < n; i++) {
+    p[i] = weights[i] * (double) n / sum; /* mean 1 */
+    if (p[i] < 1) work[nsmall++] = i;
+    else work[n - ++nlarge] = i;
+  }
+
+  while (nsmall > 0 && nlarge > 0) {
+    s = work[--nsmall];
+    l = work[n - nlarge--];
+    ap->alias[s] = l;
+    ap->thresh[s] = p[s] * 0x1.0p64 < 0x1.0p64 ? (uint64_t) (p[s] * 0x1.0p64) : UINT64_MAX;
+    p[l] = (p[l] + p[s]) - 1;
+    if (p[l] < 1) work[nsmall++] = l;
+    else work[n - ++nlarge] = l;
+  }
+  /* the rest are 1 (up to rounding): always themselves */
+  while (nlarge > 0) {
+    l = work[n - nlarge--];
+    ap->alias[l] = l;
+    ap->thresh[l] = UINT64_MAX;
+  }
+  while (nsmall > 0) {
+    s = work[--nsmall];
+    ap->alias[s] = s;
+    ap->thresh[s] = UINT64_MAX;
+  }
+
+  ap->n = n;
+  free(p);
+  free(work);
+  return 0;
+}
+
+/** Draw an index 0..n-1 with probability proportional to its weight */
+size_t
+rand_alias_draw(rand_state *rs, const rand_alias *ap)
+{
+  uint64_t col, lo = mul128(rand_next(rs), ap->n, &col);
+  return lo < ap->thresh[col] ? (size_t) col : ap->alias[col];
+}
+
+/** Draw m indices into out[] */
+void
+rand_alias_drawv(rand_state *rs, const rand_alias *ap, size_t out[], size_t m)
+{
+  uint64_t buf[BATCH], col, lo;
+  size_t i, j, c;
+
+  for (i = 0; i < m; i += c) {
+    c = m - i < BATCH ? m - i : BATCH;
+    rand_fill(rs, buf, c);
+    for (j = 0; j < c; j++) {
+      lo = mul128(buf[j], ap->n, &col);
+      out[i+j] = lo < ap->thresh[col] ? (size_t) col : ap->alias[col];
+    }
+  }
+}
+
+/** Release the table */
+void
+rand_alias_free(rand_alias *ap)
+{
+  if (!ap) return;
+  free(ap->thresh);
+  free(ap->alias);
+  ap->thresh = 0;
+  ap->alias = 0;
+  ap->n = 0;
+}
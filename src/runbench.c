@@ -0,0 +1,257 @@
+/* Benchmark Runner
+ *
+ * Usage: runbench [-t] [-c] [-p] [filter]
+ *   -t  tab-separated output (for diffing runs)
+ *   -c  also count cycles with rdtsc (x86 only)
+ *   -p  also read hardware counters (Linux perf_event_open)
+ *   filter: run only benchmarks whose name contains it
+ *
+ * Build with optimization for meaningful numbers, e.g.
+ * make bin/runbench CFLAGS="-O2 -Isrc"
+ */
+
+/* required for clock_gettime, dup, fdopen */
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "bench.h"
+#include "buf.h"
+#include "iniconf.h"
+#include "myutils.h"
+#include "perfctr.h"
+#include "print.h"
+#include "scan.h"
+#include "simpleio.h"
+#include "strbuf.h"
+#include "utf8.h"
+
+#define N 1000
+
+static void
+bench_strbuf(void)
+{
+  strbuf sb = {0};
+  int i = 0;
+
+  BENCH_HEADING("strbuf");
+  BENCH("sbaddc", 100*N, if (sblen(&sb) > 4096) sbtrunc(&sb, 0); sbaddc(&sb, 'x'));
+  BENCH("sbaddz", 10*N, if (sblen(&sb) > 4096) sbtrunc(&sb, 0); sbaddz(&sb, "hello, world"));
+  BENCHBYTES("sbaddb 64", 10*N, 64, if (sblen(&sb) > 4096) sbtrunc(&sb, 0);
+        sbaddb(&sb, "0123456789abcdef0123456789abcdef0123456789abcdef0123456789abcdef", 64));
+  BENCH("sbaddf", N, if (sblen(&sb) > 4096) sbtrunc(&sb, 0); sbaddf(&sb, "%d:%s;", i++, "abc"));
+  sbfree(&sb);
+}
+
+static void
+bench_buf(void)
+{
+  int *v = 0;
+  int i = 0;
+
+  BENCH_HEADING("buf");
+  BENCH("buf_push", 100*N, if (buf_size(v) >= 4096) buf_clear(v); buf_push(v, i); i++);
+  BENCH("buf_pop", 100*N, if (buf_size(v) == 0) buf_push(v, i); i += buf_pop(v));
+  DONOTOPTIMIZE(i);
+  buf_free(v);
+}
+
+static void
+bench_getln(void)
+{
+  strbuf sb = {0};
+  FILE *fp = tmpfile();
+  long n = 0, size;
+  int i;
+
+  if (!fp) { perror("runbench: tmpfile"); return; }
+  for (i = 0; i < 1000; i++)
+    fprintf(fp, "line %d of the file, with some text to make it typical\n", i);
+  size = ftell(fp);
+
+  BENCH_HEADING("getln");
+  BENCHBYTES("getln 1000 lines", 10, size, rewind(fp); while (getln(fp, &sb, 0) > 0) n++);
+  BENCHBYTES("eatln 1000 lines", 10, size, rewind(fp); while (eatln(fp) > 0) n++);
+  DONOTOPTIMIZE(n);
+
+  fclose(fp);
+  sbfree(&sb);
+}
+
+static void
+bench_scan(void)
+{
+  static const char text[] = "    \t  abc,def;ghi jklmnopqrstuvwxyz0123456789";
+  static const char word[] = "thequickbrownfoxjumpsoverthelazydog!"; /* 35 letters */
+  static const struct scanschema schema = { ',', '"', "dusx" };
+  static const char record[] = "-1234,567890,\"quoted, text\",ff00";
+  struct scanfield fields[4];
+  unsigned long ul;
+  int64_t i64;
+  struct tm tm;
+  charset cs;
+  int i, n;
+
+  charset_init(&cs, "abcdefghijklmnopqrstuvwxyz");
+
+  BENCH_HEADING("scan");
+  BENCH("scanint", 100*N, n = scanint("-2147483647", &i); DONOTOPTIMIZE(i));
+  BENCH("scanulong", 100*N, n = scanulong("4294967295", &ul); DONOTOPTIMIZE(ul));
+  BENCH("scanint64", 100*N, n = scanint64("-9223372036854775807", &i64); DONOTOPTIMIZE(i64));
+  BENCH("scanhex", 100*N, n = scanhex("deadbeef", &ul); DONOTOPTIMIZE(ul));
+  BENCH("scanblank", 100*N, n = scanblank(text); DONOTOPTIMIZE(n));
+  BENCHBYTES("scanwhile", 100*N, sizeof word - 2, n = scanwhile(word, "abcdefghijklmnopqrstuvwxyz"); DONOTOPTIMIZE(n));
+  BENCHBYTES("scanset_while", 100*N, sizeof word - 2, n = scanset_while(word, &cs); DONOTOPTIMIZE(n));
+  BENCH("scanpat", 100*N, n = scanpat("foobar.txt", "*.txt"); DONOTOPTIMIZE(n));
+  BENCHBYTES("scanrecord", 10*N, sizeof record - 1, n = scanrecord(record, sizeof record - 1, &schema, fields); DONOTOPTIMIZE(n));
+  BENCH("utcscan", 10*N, n = (int) utcscan("2024-02-29T12:34:56Z", &tm); DONOTOPTIMIZE(n));
+}
+
+static void
+bench_print(void)
+{
+  char buf[256];
+  size_t n;
+
+  BENCH_HEADING("print");
+  BENCH("printu", 100*N, n = printu(buf, 4294967295UL); DONOTOPTIMIZE(n));
+  BENCH("printd", 100*N, n = printd(buf, -123456789L); DONOTOPTIMIZE(n));
+  BENCH("printx", 100*N, n = printx(buf, 0xdeadbeefUL); DONOTOPTIMIZE(n));
+  BENCH("print0u", 100*N, n = print0u(buf, 42, 8); DONOTOPTIMIZE(n));
+  BENCH("prints", 100*N, n = prints(buf, "hello, world"); DONOTOPTIMIZE(n));
+  BENCHBYTES("hexencode 32", 10*N, 32, n = hexencode(buf, "0123456789abcdef0123456789abcdef", 32); DONOTOPTIMIZE(n));
+  BENCH("format", 10*N, n = format(buf, sizeof buf, "%s=%d (%x)", "key", -42, 255); DONOTOPTIMIZE(n));
+  BENCH("utcstamp", 10*N, n = utcstamp(buf, 'T'); DONOTOPTIMIZE(n));
+}
+
+static void
+bench_utf8(void)
+{
+  static const char text[] = /* mixed ASCII, 2, 3, 4 byte sequences */
+    "Gr\xc3\xbc\xc3\x9f" "e aus Z\xc3\xbcrich! \xe2\x82\xac 100, \xf0\x9f\x98\x80 "
+    "plain ascii text to make it more typical of real input";
+  const char *p, *end = text + sizeof text - 1;
+  char buf[8];
+  size_t n;
+  int c, i = 0;
+
+  BENCH_HEADING("utf8");
+  BENCHBYTES("utf8get text", N, sizeof text - 1, for (p = text; p < end; p += utf8get(p, &c)) i += c; DONOTOPTIMIZE(i));
+  BENCHBYTES("UTF8_GET text", N, sizeof text - 1, for (p = text; p < end; ) { UTF8_GET(c, p, end); i += c; } DONOTOPTIMIZE(i));
+  BENCHBYTES("utf8len text", N, sizeof text - 1, n = utf8len(text, sizeof text - 1); DONOTOPTIMIZE(n));
+  BENCH("utf8put", 100*N, n = utf8put(0x20AC, buf); DONOTOPTIMIZE(n));
+}
+
+static int
+count(iniconf_view section, iniconf_view name, iniconf_view value, size_t lineno, void *userdata)
+{
+  (void) section, (void) name, (void) value, (void) lineno;
+  ++*(size_t *) userdata;
+  return 0;
+}
+
+static int
+countbatch(const iniconf_entry entries[], size_t n, void *userdata)
+{
+  (void) entries;
+  *(size_t *) userdata += n;
+  return 0;
+}
+
+static void
+bench_iniconf(void)
+{
+  strbuf sb = {0};
+  iniconf_store *sp;
+  const char *v;
+  size_t n = 0;
+  int i, j, r;
+
+  for (i = 0; i < 100; i++) { /* 100 sections of 10 entries */
+    sbaddf(&sb, "[section%d]\n; comment\n", i);
+    for (j = 0; j < 10; j++)
+      sbaddf(&sb, "name%d = value %d of section %d\n", j, j, i);
+  }
+  sp = iniconf_loadmem(sbptr(&sb), sblen(&sb));
+
+  BENCH_HEADING("iniconf");
+  BENCHBYTES("iniconf_mem 1000 entries", 10, sblen(&sb), r = iniconf_mem(sbptr(&sb), sblen(&sb), count, &n); DONOTOPTIMIZE(r));
+  BENCHBYTES("iniconf_batch 1000 entries", 10, sblen(&sb), r = iniconf_batch(sbptr(&sb), sblen(&sb), 0, countbatch, &n); DONOTOPTIMIZE(r));
+  BENCH("iniconf_loadmem", 10, iniconf_free(iniconf_loadmem(sbptr(&sb), sblen(&sb))));
+  BENCH("iniconf_get", 100*N, v = iniconf_get(sp, "section42", "name7", ""); DONOTOPTIMIZE(v));
+  DONOTOPTIMIZE(n);
+
+  iniconf_free(sp);
+  sbfree(&sb);
+}
+
+static void
+bench_simpleio(void)
+{
+  char buf[64];
+  long n;
+  int c, partial, fd;
+
+  /* simpleio writes to fd 1: report to a copy of it */
+  fflush(stdout);
+  if ((fd = dup(1)) < 0 || !(bench.out = fdopen(fd, "w"))) {
+    perror("runbench");
+    return;
+  }
+  if (setout("/dev/null") < 0 || setin("/dev/zero") < 0) {
+    perror("runbench");
+    return;
+  }
+  putmode(SIOFULLBUF);
+
+  BENCH_HEADING("simpleio");
+  BENCH("putbyte", 100*N, putbyte('x'));
+  BENCH("putstr", 10*N, putstr("hello, world\n"));
+  BENCHBYTES("putbuf 64", 10*N, 64, putbuf("0123456789abcdef0123456789abcdef0123456789abcdef0123456789abcdef", 64));
+  BENCH("getbyte", 100*N, c = getbyte(); DONOTOPTIMIZE(c));
+  BENCHBYTES("getline 64", 10*N, 63, n = getline(buf, sizeof buf, '\n', &partial); DONOTOPTIMIZE(n));
+
+  putflush();
+  fflush(bench.out);
+  dup2(fd, 1);
+  fclose(bench.out);
+  bench.out = 0;
+}
+
+int
+main(int argc, char **argv)
+{
+  perfctr pc;
+  int i, perf = 0;
+
+  for (i = 1; i < argc; i++) {
+    if (streq(argv[i], "-t")) bench.tsv = 1;
+    else if (streq(argv[i], "-c")) bench.cycles = 1;
+    else if (streq(argv[i], "-p")) perf = 1;
+    else if (argv[i][0] == '-') {
+      fprintf(stderr, "Usage: %s [-t] [-c] [-p] [filter]\n", argv[0]);
+      return 1;
+    }
+    else bench.filter = argv[i];
+  }
+
+  if (perf) {
+    if (perfctr_open(&pc) > 0) bench.perf = &pc;
+    else perror("runbench: no hardware counters");
+  }
+
+  bench_strbuf();
+  bench_buf();
+  bench_getln();
+  bench_scan();
+  bench_print();
+  bench_utf8();
+  bench_iniconf();
+  bench_simpleio();
+
+  if (bench.perf) perfctr_close(bench.perf);
+  return 0;
+}
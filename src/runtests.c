@@ -1,11 +1,39 @@
-/* Test Runner */
+/* Test Runner
+ *
+ * Usage: runtests [-s] [-q] [-j jobs] [-t seconds] [filter...]
+ *   -s  run the suites one after another in this process
+ *       (no fork; for use under a debugger)
+ *   -q  quiet: print only failed tests and the suite summary
+ *   -j  run up to this many suites at once (default: #CPUs)
+ *   -t  kill a suite that runs longer (default 60, 0: no limit)
+ *   filter: run only suites whose name contains one of them
+ *
+ * Each suite runs in a child process, with its stdout and stderr
+ * going to a pipe, so that a suite that crashes (or longjmps into
+ * the void, or leaves fds or rlimits changed behind it) cannot take
+ * the others with it. The child reports its pass and fail counts
+ * over a second pipe; a suite that dies or times out counts as one
+ * failure. The output of the suites is printed in the order below,
+ * whatever order they complete in.
+ */
 
+/* required for fork, pipe, poll, kill, clock_gettime */
+#define _POSIX_C_SOURCE 200112L
+
+#include <errno.h>
+#include <poll.h>
+#include <signal.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
 
+#include "strbuf.h"
 #include "test.h"
 
-#define UNUSED(x) (void)(x)
-
 extern void scan_test(int *pnumpass, int *pnumfail);
 extern void print_test(int *pnumpass, int *pnumfail);
 extern void buf_test(int *pnumpass, int *pnumfail);
@@ -16,26 +44,274 @@ extern void scf_test(int *pnumpass, int *pnumfail);
 extern void iniconf_test(int *pnumpass, int *pnumfail);
 extern void getopt_test(int *pnumpass, int *pnumfail);
 extern void utf8_test(int *pnumpass, int *pnumfail);
+extern void rand_test(int *pnumpass, int *pnumfail);
+extern void byteorder_test(int *pnumpass, int *pnumfail);
+extern void varint_test(int *pnumpass, int *pnumfail);
+extern void fuzz_test(int *pnumpass, int *pnumfail);
+
+static const struct {
+  const char *name;
+  void (*run)(int *pnumpass, int *pnumfail);
+} suites[] = {
+  { "scan", scan_test },
+  { "print", print_test },
+  { "buf", buf_test },
+  { "strbuf", strbuf_test },
+  { "myutils", myutils_test },
+  { "simpleio", simpleio_test },
+  { "scf", scf_test },
+  { "iniconf", iniconf_test },
+  { "getopt", getopt_test },
+  { "utf8", utf8_test },
+  { "rand", rand_test },
+  { "byteorder", byteorder_test },
+  { "varint", varint_test },
+  { "fuzz", fuzz_test },
+};
+
+#define NSUITES (sizeof suites / sizeof suites[0])
+
+struct suite {      /* a suite selected to run */
+  const char *name;
+  void (*run)(int *pnumpass, int *pnumfail);
+  pid_t pid;        /* child running it, or 0 */
+  int outfd;        /* its stdout and stderr, or -1 */
+  int resfd;        /* its pass and fail counts, or -1 */
+  strbuf out;       /* output collected so far */
+  double start, secs;
+  int numpass, numfail;
+  int status;       /* from waitpid */
+  int timedout;
+  int done;
+};
+
+static int quiet;
+
+static double
+now(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double) ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static int
+selected(const char *name, char **filters, int nfilters)
+{
+  int i;
+  if (nfilters == 0) return 1;
+  for (i = 0; i < nfilters; i++)
+    if (strstr(name, filters[i])) return 1;
+  return 0;
+}
+
+static int
+start(struct suite *s)
+{
+  int out[2], res[2];
+  char buf[64];
+  int n;
+
+  if (pipe(out) < 0) return -1;
+  if (pipe(res) < 0) { close(out[0]); close(out[1]); return -1; }
+
+  fflush(stdout); /* or the child prints it again */
+  s->start = now();
+  s->pid = fork();
+  if (s->pid < 0) {
+    close(out[0]); close(out[1]); close(res[0]); close(res[1]);
+    return -1;
+  }
+
+  if (s->pid == 0) {
+    close(out[0]);
+    close(res[0]);
+    dup2(out[1], 1);
+    dup2(out[1], 2);
+    close(out[1]);
+    setvbuf(stdout, 0, _IOLBF, 0); /* keep output up to a crash */
+    s->run(&s->numpass, &s->numfail);
+    fflush(stdout);
+    n = sprintf(buf, "%d %d\n", s->numpass, s->numfail);
+    _exit(write(res[1], buf, n) == n ? 0 : 1);
+  }
+
+  close(out[1]);
+  close(res[1]);
+  s->outfd = out[0];
+  s->resfd = res[0];
+  return 0;
+}
+
+static void
+collect(struct suite *s)
+{ /* read what is there (poll said so) or until EOF if reaped */
+  char buf[4096];
+  ssize_t n;
+
+  do n = read(s->outfd, buf, sizeof buf);
+  while (n < 0 && errno == EINTR);
+  if (n > 0) sbaddb(&s->out, buf, n);
+  else { close(s->outfd); s->outfd = -1; }
+}
+
+static void
+finish(struct suite *s)
+{
+  char buf[64];
+  ssize_t n;
+
+  s->secs = now() - s->start;
+  while (s->outfd >= 0) collect(s);
+  n = read(s->resfd, buf, sizeof buf - 1);
+  close(s->resfd);
+  s->resfd = -1;
+  buf[n > 0 ? n : 0] = 0;
+  if (sscanf(buf, "%d %d", &s->numpass, &s->numfail) != 2 ||
+      !WIFEXITED(s->status) || WEXITSTATUS(s->status) != 0) {
+    s->numfail++; /* died before reporting */
+  }
+  s->pid = 0;
+  s->done = 1;
+}
+
+static void
+show(struct suite *s)
+{
+  const char *p = sbptr(&s->out), *eol;
+
+  if (!quiet) fputs(p, stdout);
+  else for (; *p; p = eol) { /* only failures */
+    eol = strchr(p, '\n');
+    eol = eol ? eol + 1 : p + strlen(p);
+    if (!strncmp(p, TERMFAIL, strlen(TERMFAIL)))
+      fwrite(p, 1, eol - p, stdout);
+  }
+  if (s->timedout)
+    printf(TERMFAIL " suite %s: timed out\n", s->name);
+  else if (WIFSIGNALED(s->status))
+    printf(TERMFAIL " suite %s: killed by signal %d\n", s->name, WTERMSIG(s->status));
+  else if (!WIFEXITED(s->status) || WEXITSTATUS(s->status) != 0)
+    printf(TERMFAIL " suite %s: exit status %d\n", s->name, WEXITSTATUS(s->status));
+  fflush(stdout);
+  sbfree(&s->out);
+}
+
+static void
+runall(struct suite *ss[], int n, int jobs, int timeout)
+{
+  struct pollfd fds[NSUITES];
+  struct suite *polled[NSUITES];
+  int next = 0, shown = 0, running = 0, i, k;
+
+  while (shown < n) {
+    while (running < jobs && next < n) {
+      if (start(ss[next]) < 0) {
+        perror("runtests: cannot start suite");
+        ss[next]->numfail = 1;
+        ss[next]->done = 1;
+      }
+      else running++;
+      next++;
+    }
+
+    for (i = k = 0; i < next; i++) {
+      if (ss[i]->pid == 0 || ss[i]->outfd < 0) continue;
+      fds[k].fd = ss[i]->outfd;
+      fds[k].events = POLLIN;
+      polled[k++] = ss[i];
+    }
+    /* a child whose output is at EOF is about to exit: don't wait long */
+    if (poll(fds, k, k < running ? 1 : 100) > 0)
+      for (i = 0; i < k; i++)
+        if (fds[i].revents) collect(polled[i]);
+
+    for (i = 0; i < next; i++) {
+      struct suite *s = ss[i];
+      if (s->pid == 0) continue;
+      if (waitpid(s->pid, &s->status, WNOHANG) == s->pid) {
+        finish(s);
+        running--;
+      }
+      else if (timeout > 0 && now() - s->start > timeout) {
+        kill(s->pid, SIGKILL);
+        waitpid(s->pid, &s->status, 0);
+        s->timedout = 1;
+        finish(s);
+        running--;
+      }
+    }
+
+    while (shown < next && ss[shown]->done)
+      show(ss[shown++]);
+  }
+}
+
+static void
+runinline(struct suite *ss[], int n)
+{
+  int i;
+  for (i = 0; i < n; i++) {
+    ss[i]->start = now();
+    ss[i]->run(&ss[i]->numpass, &ss[i]->numfail);
+    ss[i]->secs = now() - ss[i]->start;
+    ss[i]->done = 1;
+  }
+}
+
+static void
+usage(const char *me)
+{
+  fprintf(stderr, "Usage: %s [-s] [-q] [-j jobs] [-t seconds] [filter...]\n", me);
+  exit(2);
+}
 
 int
 main(int argc, char **argv)
 {
+  struct suite all[NSUITES], *ss[NSUITES];
   int numpass = 0;
   int numfail = 0;
+  int nofork = 0, jobs = 0, timeout = 60;
+  int i, n, nfilters = 0;
+  char **filters = argv + 1;
+  double start = now();
+
+  for (i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "-s")) nofork = 1;
+    else if (!strcmp(argv[i], "-q")) quiet = 1;
+    else if (!strcmp(argv[i], "-j") && i+1 < argc) jobs = atoi(argv[++i]);
+    else if (!strcmp(argv[i], "-t") && i+1 < argc) timeout = atoi(argv[++i]);
+    else if (argv[i][0] == '-') usage(argv[0]);
+    else filters[nfilters++] = argv[i];
+  }
+
+#ifdef _SC_NPROCESSORS_ONLN
+  if (jobs <= 0) jobs = (int) sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+  if (jobs <= 0) jobs = 1;
+
+  memset(all, 0, sizeof all);
+  for (i = n = 0; i < (int) NSUITES; i++) {
+    if (!selected(suites[i].name, filters, nfilters)) continue;
+    all[i].name = suites[i].name;
+    all[i].run = suites[i].run;
+    all[i].outfd = all[i].resfd = -1;
+    ss[n++] = &all[i];
+  }
+
+  if (nofork) runinline(ss, n);
+  else runall(ss, n, jobs, timeout);
 
-  UNUSED(argc);
-  UNUSED(argv);
-
-  scan_test(&numpass, &numfail);
-  print_test(&numpass, &numfail);
-  buf_test(&numpass, &numfail);
-  strbuf_test(&numpass, &numfail);
-  myutils_test(&numpass, &numfail);
-  simpleio_test(&numpass, &numfail);
-  scf_test(&numpass, &numfail);
-  iniconf_test(&numpass, &numfail);
-  getopt_test(&numpass, &numfail);
-  utf8_test(&numpass, &numfail);
+  printf(TERMHEAD, "Suites");
+  for (i = 0; i < n; i++) {
+    printf("  %-12s %4d pass %4d fail %8.3f s\n",
+           ss[i]->name, ss[i]->numpass, ss[i]->numfail, ss[i]->secs);
+    numpass += ss[i]->numpass;
+    numfail += ss[i]->numfail;
+  }
+  printf("  %-12s %4d suites, %d jobs %6.3f s\n", "all", n,
+         nofork ? 1 : jobs, now() - start);
 
   SUMMARY(numpass, numfail);
   return numfail > 0 ? 1 : 0;
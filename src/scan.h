@@ -9,8 +9,15 @@
 int scanint(const char *s, int *pval);
 int scanuint(const char *s, unsigned int *pval);
 int scanulong(const char *s, unsigned long *pval);
+
+#include <stdint.h> /* int64_t, uint64_t */
+int scanint64(const char *s, int64_t *pval);
+int scanuint64(const char *s, uint64_t *pval);
 int scanhex(const char *s, unsigned long *pval);
 
+#include <stddef.h> /* size_t */
+size_t hexdecode(void *buf, const char *s, size_t n); /* 2n hex digits */
+
 int scanblank(const char *s); /* space and tab */
 int scanwhite(const char *s); /* space \f \n \r \t \v */
 int scantext(const char *s, const char *t);
@@ -18,11 +25,50 @@ int scanpat(const char *s, const char *pat); /* foo: E* */
 int scanuntil(const char *s, const char *reject); /* strcspn */
 int scanwhile(const char *s, const char *accept); /* strspn */
 
+typedef struct charset {
+  unsigned char bits[32];     /* bitmap: bit c set iff c in set */
+  unsigned char lo[16];       /* by low nibble: bits for high nibbles 0..7 */
+  unsigned char hi[16];       /* by low nibble: bits for high nibbles 8..15 */
+  unsigned char members[16];  /* the members, if there are <= 16 */
+  int nmembers;               /* number of (distinct) members */
+} charset;
+
+void charset_init(charset *cs, const char *set);
+int scanset_while(const char *s, const charset *cs); /* like scanwhile */
+int scanset_until(const char *s, const charset *cs); /* like scanuntil */
+
 int scanip4(const char *s, unsigned char ip[4]); /* 192.168.1.2 */
 int scanip4op(const char *s, unsigned char ip[4], unsigned *port); /* 10.1.2.3:4321 */
 
+struct patset {
+  struct patnode *nodes;  /* the compiled patterns (a trie) */
+  int *next;              /* next pattern ending at same node */
+  int rootlit[256];       /* root's child for a literal char */
+  int npats;              /* number of patterns added */
+};                        /* initialize as in: struct patset ps = {0}; */
+
+int patset_add(struct patset *ps, const char *pat); /* index of pat */
+int patset_match(const struct patset *ps, const char *s, int counts[]);
+void patset_free(struct patset *ps);
+
+struct scanfield {
+  const char *ptr;  /* field text (without quotes) */
+  size_t len;       /* length of field text */
+  union { int64_t i; uint64_t u; } val; /* numeric fields */
+};
+
+struct scanschema {
+  int delim;          /* field separator, like ',' or '\t' */
+  int quote;          /* quote char, like '"', or 0 for none */
+  const char *types;  /* one per field: d=int64 u=uint64 x=hex s=text */
+};
+
+/* returns #fields scanned, not #bytes! */
+int scanrecord(const char *line, size_t len, const struct scanschema *sp, struct scanfield out[]);
+
 #include <time.h> /* struct tm */
 int scandate(const char *s, struct tm *tp); /* 2005-07-15 */
 int scantime(const char *s, struct tm *tp); /* 12:34:45 */
+int scanzone(const char *s, int *offset); /* Z or +02:00, in minutes */
 
 #endif
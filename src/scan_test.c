@@ -2,8 +2,10 @@
 
 #include "test.h"
 
+#include <inttypes.h>
 #include <limits.h>
 #include <stdio.h>
+#include <string.h>
 #include <time.h>
 
 #include "scan.h"
@@ -12,13 +14,29 @@ void
 scan_test(int *pnumpass, int *pnumfail)
 {
   char buf[64];
+  char hex[120];
   int n;
   int i;
   unsigned int ui;
   unsigned long ul;
+  int64_t i64;
+  uint64_t u64;
+  int ok;
   unsigned char ip[4];
   unsigned int port;
   struct tm tm;
+  struct scanschema schema;
+  charset cs;
+  struct patset ps = {0};
+  static const char *pats[] = { "abc", " abc ", "*x*y*z*", " foo: E* ",
+    "foo: E* ", "foo: E*", "*", "", " ", "foo", "* *", "**", "a*", "a*b",
+    "  \t  x", "\tx", "abc*" };
+  static const char *lines[] = { "abcd", "\t abc \tz", "abc   z", "xyz",
+    "!x!!y!!!z!!!!", "foo: EINTR x", "foo: EINTRx", "", " ", "a*b", "ab*",
+    "\tx", "  x", "x y", "abc" };
+  const int npats = sizeof pats / sizeof *pats;
+  int counts[sizeof pats / sizeof *pats];
+  struct scanfield fields[10];
 
   int numpass = 0;
   int numfail = 0;
@@ -32,6 +50,10 @@ scan_test(int *pnumpass, int *pnumfail)
   TEST("scanint INT_MAX", scanint(buf, &i) == n && i == INT_MAX);
   n = snprintf(buf, sizeof buf, "%d", INT_MIN);
   TEST("scanint INT_MIN", scanint(buf, &i) == n && i == INT_MIN);
+  snprintf(buf, sizeof buf, "%ld", (long) INT_MAX + 1);
+  TEST("scanint INT_MAX+1 overflows", scanint(buf, &i) == 0);
+  snprintf(buf, sizeof buf, "%ld", (long) INT_MIN - 1);
+  TEST("scanint INT_MIN-1 overflows", scanint(buf, &i) == 0);
 
   HEADING("Testing scanuint()");
   TEST("scanuint 000", scanuint("000", &ui) == 3 && ui == 0);
@@ -39,6 +61,8 @@ scan_test(int *pnumpass, int *pnumfail)
   TEST("scanuint 12x", scanuint("12x", &ui) == 2 && ui == 12);
   n = snprintf(buf, sizeof buf, "%u", UINT_MAX);
   TEST("scanuint UINT_MAX", scanuint(buf, &ui) == n && ui == UINT_MAX);
+  snprintf(buf, sizeof buf, "%lu", (unsigned long) UINT_MAX + 1);
+  TEST("scanuint UINT_MAX+1 overflows", scanuint(buf, &ui) == 0);
 
   HEADING("Testing scanulong()");
   TEST("scanulong -1", scanulong("-1", &ul) == 0);
@@ -46,6 +70,29 @@ scan_test(int *pnumpass, int *pnumfail)
   n = snprintf(buf, sizeof buf, "%lu", ULONG_MAX);
   TEST("scanulong ULONG_MAX", scanulong(buf, &ul) == n && ul == ULONG_MAX);
 
+  TEST("scanulong ULONG_MAX+1 overflows",
+    scanulong("18446744073709551616", &ul) == 0 || ULONG_MAX < UINT64_MAX);
+
+  HEADING("Testing scanint64()/scanuint64()");
+  TEST("scanuint64 0", scanuint64("0", &u64) == 1 && u64 == 0);
+  TEST("scanuint64 12345678", scanuint64("12345678", &u64) == 8 && u64 == 12345678);
+  TEST("scanuint64 123456789x", scanuint64("123456789x", &u64) == 9 && u64 == 123456789);
+  TEST("scanuint64 leading zeros", scanuint64("000000000000000000000042", &u64) == 24 && u64 == 42);
+  TEST("scanuint64 UINT64_MAX", scanuint64("18446744073709551615", &u64) == 20 && u64 == UINT64_MAX);
+  TEST("scanuint64 UINT64_MAX+1", scanuint64("18446744073709551616", &u64) == 0);
+  TEST("scanuint64 21 digits", scanuint64("100000000000000000000", &u64) == 0);
+  TEST("scanint64 INT64_MIN", scanint64("-9223372036854775808", &i64) == 20 && i64 == INT64_MIN);
+  TEST("scanint64 INT64_MAX", scanint64("+9223372036854775807", &i64) == 20 && i64 == INT64_MAX);
+  TEST("scanint64 INT64_MIN-1", scanint64("-9223372036854775809", &i64) == 0);
+  TEST("scanint64 INT64_MAX+1", scanint64("9223372036854775808", &i64) == 0);
+  TEST("scanint64 -0", scanint64("-0", &i64) == 2 && i64 == 0);
+  for (n = 0, ok = 1, u64 = 1; n < 20; n++, u64 = 10*u64 + n%10) {
+    uint64_t v;
+    snprintf(buf, sizeof buf, "%" PRIu64 ";", u64);
+    ok &= scanuint64(buf, &v) == (int) strlen(buf)-1 && v == u64;
+  }
+  TEST("scanuint64 1..20 digits", ok);
+
   HEADING("Testing scanhex()");
   TEST("scanhex 00000000", scanhex("00000000", &ul) == 8 && ul == 0);
   TEST("scanhex DeadBeef", scanhex("DeadBeef", &ul) == 8 && ul == 0xDeadBeef);
@@ -53,6 +100,23 @@ scan_test(int *pnumpass, int *pnumfail)
   n = snprintf(buf, sizeof buf, "%lx", ULONG_MAX);
   TEST("scanhex ULONG_MAX", scanhex(buf, &ul) == n && ul == ULONG_MAX);
 
+  HEADING("Testing hexdecode()");
+  TEST("hexdecode DeadBeef", hexdecode(buf, "DeadBeefX", 4) == 8
+    && !memcmp(buf, "\xDE\xAD\xBE\xEF", 4));
+  TEST("hexdecode stop at odd digit", hexdecode(buf, "abcdeX", 3) == 4);
+  TEST("hexdecode stop at n", hexdecode(buf, "0102030405", 2) == 4);
+  TEST("hexdecode short string", hexdecode(buf, "4142", 60) == 4
+    && buf[0] == 'A' && buf[1] == 'B');
+  for (i = 0; i < 60; i++) {
+    hex[2*i] = "0123456789abcdef"[i/16];
+    hex[2*i+1] = "0123456789ABCDEF"[i%16];
+  }
+  TEST("hexdecode long", hexdecode(buf, hex, 60) == 120
+    && buf[0] == 0x00 && buf[17] == 0x11 && buf[59] == 0x3B);
+  hex[101] = 'g';
+  TEST("hexdecode long invalid", hexdecode(buf, hex, 60) == 100
+    && buf[49] == 0x31);
+
   HEADING("Testing scanblank()");
   TEST("scanblank null", scanblank(NULL) == 0);
   TEST("scanblank empty", scanblank("") == 0);
@@ -80,6 +144,23 @@ scan_test(int *pnumpass, int *pnumfail)
   TEST("scanpat ditto other input", scanpat("foo: EINTRx", "foo: E* ") == 0);
   TEST("scanpat null", scanpat(NULL, NULL) == 0);
 
+  HEADING("Testing patset_add()/patset_match()");
+  for (i = 0; i < npats; i++) patset_add(&ps, pats[i]);
+  for (i = 0, ok = 1; i < (int) (sizeof lines / sizeof *lines); i++) {
+    int j, m = 0;
+    n = patset_match(&ps, lines[i], counts);
+    for (j = 0; j < npats; j++) {
+      ok &= counts[j] == scanpat(lines[i], pats[j]);
+      m += counts[j] > 0;
+    }
+    ok &= n == m;
+  }
+  TEST("patset_match same as scanpat", ok);
+  TEST("patset_match foo: E*", patset_match(&ps, "foo: EINTR x", counts) == 7
+    && counts[3] == 11 && counts[5] == 12 && counts[9] == 3 && counts[0] == 0);
+  patset_free(&ps);
+  TEST("patset_free", ps.npats == 0 && patset_match(&ps, "abc", counts) == 0);
+
   HEADING("Testing scanuntil()");
   TEST("scanuntil abz null", scanuntil("abz", NULL) == 3);
   TEST("scanuntil abz xyz", scanuntil("abz", "xyz") == 2);
@@ -88,6 +169,52 @@ scan_test(int *pnumpass, int *pnumfail)
   TEST("scanwhile abz null", scanwhile("abz", NULL) == 0);
   TEST("scanwhile abz abc", scanwhile("abz", "abc") == 2);
 
+  HEADING("Testing scanrecord()");
+  schema.delim = ',';
+  schema.quote = '"';
+  schema.types = "sdux";
+  TEST("scanrecord simple", scanrecord("foo,-12,34,fF\n", 14, &schema, fields) == 4
+    && fields[0].len == 3 && !strncmp(fields[0].ptr, "foo", 3)
+    && fields[1].val.i == -12 && fields[2].val.u == 34 && fields[3].val.u == 255);
+  TEST("scanrecord quoted", scanrecord("\"a,\"\"b\",\"7\",8,9", 15, &schema, fields) == 4
+    && fields[0].len == 5 && !strncmp(fields[0].ptr, "a,\"\"b", 5)
+    && fields[1].val.i == 7 && fields[2].val.u == 8 && fields[3].val.u == 9);
+  TEST("scanrecord after quote", scanrecord("x,\"1\"2,3,4", 11, &schema, fields) == 1
+    && scanrecord("\"ab\"junk,1,2,3", 15, &schema, fields) == 0);
+  TEST("scanrecord bad number", scanrecord("x,1,2z,3", 8, &schema, fields) == 2);
+  TEST("scanrecord too few", scanrecord("x,1", 3, &schema, fields) == 2);
+  TEST("scanrecord extra fields", scanrecord("x,1,2,3,more", 12, &schema, fields) == 4
+    && fields[3].len == 1 && fields[3].val.u == 3);
+  TEST("scanrecord unterminated", scanrecord("x,1,2,3456", 8, &schema, fields) == 4
+    && fields[3].val.u == 0x34);
+  schema.delim = '\t';
+  schema.quote = 0;
+  schema.types = "sssssssssu";
+  TEST("scanrecord long line", scanrecord("a\tb\tc\td\t\"e\"\tf\tggggggggggggggggggg\th\ti\t987654321",
+    47, &schema, fields) == 10 && fields[4].len == 3 && fields[6].len == 19
+    && fields[9].val.u == 987654321);
+
+  HEADING("Testing scanset_while()/scanset_until()");
+  charset_init(&cs, " \t");
+  TEST("scanset_while blanks", scanset_while(" \t x", &cs) == 3);
+  TEST("scanset_until blanks", scanset_until("foo bar", &cs) == 3);
+  TEST("scanset_until empty", scanset_until("", &cs) == 0);
+  TEST("scanset_until no match", scanset_until("foobar", &cs) == 6);
+  charset_init(&cs, "0123456789abcdefABCDEF\x80\xFF");
+  TEST("scanset_while >16 members", scanset_while("09afAF\x80\xFFg", &cs) == 8);
+  for (i = 0, ok = 1; i < 40; i++) {
+    memset(hex, 'a', sizeof hex);
+    hex[i] = 'z';
+    hex[sizeof hex - 1] = 0;
+    charset_init(&cs, "abc");
+    ok &= scanset_while(hex+1, &cs) == (i ? i-1 : 118);
+    charset_init(&cs, "xyz");
+    ok &= scanset_until(hex+1, &cs) == (i ? i-1 : 118);
+  }
+  TEST("scanset long strings", ok);
+  charset_init(&cs, NULL);
+  TEST("scanset empty set", scanset_while("abc", &cs) == 0 && scanset_until("abc", &cs) == 3);
+
   HEADING("Testing scanip4()");
   TEST("scanip4 192.168.1.2", scanip4("192.168.1.2", ip) == 11
     && ip[0] == 192 && ip[1] == 168 && ip[2] == 1 && ip[3] == 2);
@@ -106,6 +233,7 @@ scan_test(int *pnumpass, int *pnumfail)
     && tm.tm_year == 105 && tm.tm_mon == 6 && tm.tm_mday == 14);
   TEST("scandate -5-2-03", scandate("-5-2-03", &tm) == 7
     && tm.tm_year == -1905 && tm.tm_mon == 1 && tm.tm_mday == 3);
+  TEST("scandate overflow", scandate("12345678901-01-01", &tm) == 0);
 
   HEADING("Testing scantime()");
   TEST("scantime 12:34:56", (n=scantime("12:34:56", &tm)) == 8
@@ -113,6 +241,15 @@ scan_test(int *pnumpass, int *pnumfail)
   TEST("scantime 05:12", scantime("05:12", &tm) == 5
     && tm.tm_hour == 5 && tm.tm_min == 12 && tm.tm_sec == 0);
 
+  HEADING("Testing scanzone()");
+  TEST("scanzone Z", scanzone("Z", &i) == 1 && i == 0);
+  TEST("scanzone +02:00", scanzone("+02:00", &i) == 6 && i == 120);
+  TEST("scanzone -0530", scanzone("-0530x", &i) == 5 && i == -330);
+  TEST("scanzone +01", scanzone("+01 ", &i) == 3 && i == 60);
+  TEST("scanzone +24:00", scanzone("+24:00", &i) == 0);
+  TEST("scanzone +1", scanzone("+1", &i) == 0);
+  TEST("scanzone UTC", scanzone("UTC", &i) == 0);
+
   *pnumpass += numpass;
   *pnumfail += numfail;
 }
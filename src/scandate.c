@@ -5,13 +5,16 @@
  *  Update only tm_year, tm_mon, tm_mday;
  *  leave all other tm fields untouched!
  *
- *  Return number of bytes scanned, zero on error.
+ *  Return number of bytes scanned, zero on error
+ *  (also for absurdly long numbers that would overflow).
  *
  * Notes on struct tm:
  * tm_year is number of years since 1900.
  * tm_mon (0..11) is the number of months since January.
  * tm_mday (1..31) is the day of month (starting with 1).
  */
+#define BIG 99999999 /* so y*10 + c cannot overflow */
+
 int
 scandate(const char *s, struct tm *tp)
 {
@@ -26,17 +29,26 @@ scandate(const char *s, struct tm *tp)
   if (*p == '-') { ++p; sign = -1; } /* year may be negative! */
 
   if ((y = (unsigned char) (*p++ - '0')) > 9) return 0;
-  while ((c = (unsigned char) (*p - '0')) <= 9) { y = y*10 + c; p++; }
+  while ((c = (unsigned char) (*p - '0')) <= 9) {
+    if (y > BIG) return 0;
+    y = y*10 + c; p++;
+  }
 
   if (*p++ != '-') return 0;
 
   if ((m = (unsigned char) (*p++ - '0')) > 9) return 0;
-  while ((c = (unsigned char) (*p - '0')) <= 9) { m = m*10 + c; p++; }
+  while ((c = (unsigned char) (*p - '0')) <= 9) {
+    if (m > BIG) return 0;
+    m = m*10 + c; p++;
+  }
 
   if (*p++ != '-') return 0;
 
   if (( d = (unsigned char) (*p++ - '0')) > 9) return 0;
-  while ((c = (unsigned char) (*p - '0')) <= 9) { d = d*10 + c; p++; }
+  while ((c = (unsigned char) (*p - '0')) <= 9) {
+    if (d > BIG) return 0;
+    d = d*10 + c; p++;
+  }
 
   if (tp) {
     tp->tm_year = y * sign - 1900;
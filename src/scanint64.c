@@ -0,0 +1,35 @@
+#include "scan.h"
+
+#include <stdint.h>
+
+/** Scan an int64_t in decimal notation with optional sign;
+ *  return zero if out of range */
+int
+scanint64(const char *s, int64_t *pval)
+{
+  uint64_t u;
+  int sign, n;
+
+  if (!s) return 0;
+
+  sign = 0;
+
+  switch (*s) {
+    case '-': sign=-1; ++s; break;
+    case '+': sign=+1; ++s; break;
+  }
+
+  if ((n = scanuint64(s, &u)) == 0) return 0; /* no digits or overflow */
+
+  /* -INT64_MIN does not fit into int64_t, thus: */
+  if (sign < 0) {
+    if (u > (uint64_t) INT64_MAX + 1) return 0;
+    if (pval) *pval = u ? -(int64_t) (u - 1) - 1 : 0;
+  }
+  else {
+    if (u > INT64_MAX) return 0;
+    if (pval) *pval = (int64_t) u;
+  }
+
+  return n + (sign ? 1 : 0); /* #bytes scanned */
+}
@@ -0,0 +1,153 @@
+#include "scan.h"
+
+#include <string.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+/* Split a line into fields in one pass and scan each field
+ * according to its type in the schema. With SSE2 (always there
+ * on x86-64) the structural chars (delimiter and quote) are found
+ * 16 bytes at a time; only their positions are then visited.
+ */
+
+struct state {
+  const char *line;
+  size_t len;
+  const struct scanschema *sp;
+  struct scanfield *out;
+  size_t start;     /* index where current field starts */
+  size_t close;     /* index of closing quote, or 0 */
+  size_t skip;      /* ignore quote at this index (escaped) */
+  int quoted;       /* inside quotes */
+  int nfields;      /* #fields emitted so far */
+  int nwanted;      /* #fields in schema */
+  int error;        /* field failed to scan */
+};
+
+static int
+scanfield(struct state *st, size_t end)
+{ /* emit field line[start..end), return 0 if done */
+  const char *p = st->line + st->start;
+  size_t n = end - st->start;
+  struct scanfield *fp = &st->out[st->nfields];
+  int type = st->sp->types[st->nfields];
+  char tmp[32];
+  unsigned long ul;
+  int k;
+
+  if (st->close > st->start && *p == st->sp->quote) {
+    if (st->close + 1 != end) goto bad; /* text after the quote */
+    n = st->close - st->start - 1;
+    p += 1;
+  }
+
+  fp->ptr = p;
+  fp->len = n;
+
+  if (type != 's') {
+    if (p + n == st->line + st->len) { /* line may not be terminated */
+      if (n >= sizeof tmp) goto bad;
+      memcpy(tmp, p, n);
+      tmp[n] = '\0';
+      p = tmp;
+    }
+    switch (type) {
+      case 'd': k = scanint64(p, &fp->val.i); break;
+      case 'u': k = scanuint64(p, &fp->val.u); break;
+      case 'x': k = scanhex(p, &ul); fp->val.u = ul; break;
+      default: goto bad;
+    }
+    if (k <= 0 || (size_t) k != n) goto bad;
+  }
+
+  st->nfields += 1;
+  st->start = end + 1;
+  st->close = 0;
+  return st->nfields < st->nwanted;
+
+bad:
+  st->error = 1;
+  return 0;
+}
+
+static int
+structural(struct state *st, size_t i)
+{ /* visit delimiter or quote at line[i], return 0 if done */
+  int c = (unsigned char) st->line[i];
+
+  if (c == st->sp->quote && c != st->sp->delim) {
+    if (st->quoted) {
+      if (i == st->skip) return 1; /* 2nd of a doubled quote */
+      if (i+1 < st->len && st->line[i+1] == c) st->skip = i+1;
+      else st->quoted = 0, st->close = i;
+    }
+    else if (i == st->start) st->quoted = 1;
+    return 1; /* else: a literal quote */
+  }
+
+  if (st->quoted) return 1; /* quoted delimiter */
+  return scanfield(st, i);
+}
+
+/** Split line[0..len) at the schema's delimiter and scan each
+ *  field by its type; return the number of fields scanned */
+int
+scanrecord(const char *line, size_t len, const struct scanschema *sp, struct scanfield out[])
+{
+  struct state st;
+  size_t i = 0;
+
+  if (!line || !sp || !sp->types || !out) return 0;
+
+  /* ignore the line terminator */
+  if (len > 0 && line[len-1] == '\n') --len;
+  if (len > 0 && line[len-1] == '\r') --len;
+
+  st.line = line;
+  st.len = len;
+  st.sp = sp;
+  st.out = out;
+  st.start = st.close = st.skip = 0;
+  st.quoted = 0;
+  st.nfields = 0;
+  st.nwanted = strlen(sp->types);
+  st.error = 0;
+
+  if (st.nwanted == 0) return 0;
+
+#if defined(__SSE2__)
+  {
+    const __m128i delim = _mm_set1_epi8((char) sp->delim);
+    const __m128i quote = _mm_set1_epi8((char) (sp->quote ? sp->quote : sp->delim));
+    for (; i + 16 <= len; i += 16) {
+      __m128i v = _mm_loadu_si128((const __m128i *) (line + i));
+      unsigned m = _mm_movemask_epi8(_mm_or_si128(
+        _mm_cmpeq_epi8(v, delim), _mm_cmpeq_epi8(v, quote)));
+      for (; m; m &= m - 1) { /* visit set bits, lowest first */
+#if defined(__GNUC__)
+        size_t j = i + __builtin_ctz(m);
+#else
+        size_t j = i;
+        unsigned b;
+        for (b = m; !(b & 1); b >>= 1) j++;
+#endif
+        if (!structural(&st, j)) goto done;
+      }
+    }
+  }
+#endif
+
+  for (; i < len; i++) {
+    int c = (unsigned char) line[i];
+    if (c == sp->delim || (c == sp->quote && c)) {
+      if (!structural(&st, i)) goto done;
+    }
+  }
+
+  scanfield(&st, len); /* the last field */
+
+done:
+  return st.nfields; /* #fields scanned */
+}
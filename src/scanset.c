@@ -0,0 +1,160 @@
+#include "scan.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#if defined(__SSSE3__)
+#include <tmmintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+/* A charset is built once from a set string and can then be used
+ * by scanset_while() and scanset_until() over and over, whereas
+ * strspn(3) and strcspn(3) (and thus scanwhile and scanuntil)
+ * have to build their table from the set string on every call.
+ *
+ * The charset holds the set in three forms:
+ * 1. a 256 bit bitmap, for scanning one byte at a time;
+ * 2. the bitmap rearranged into two 16 byte tables indexed by
+ *    the low nibble of a byte, each entry having one bit for
+ *    each high nibble 0..7 (or 8..15): with SSSE3, PSHUFB then
+ *    looks up 16 bytes at once, for any set (W. Muła's method);
+ * 3. the list of members, if there are at most 16: with only
+ *    SSE2, one PCMPEQB per member tests 16 bytes at once.
+ *
+ * The SIMD loops use aligned 16 byte loads, which may read beyond
+ * the terminating \0 of s but never across a page boundary.
+ * AddressSanitizer would report those reads, so with it we
+ * always scan byte by byte.
+ */
+
+#define ALIGN 16
+
+#define HAS(cs, c) ((cs)->bits[(c) >> 3] & (1 << ((c) & 7)))
+
+/** Build charset cs from the bytes in set (\0 is never a member) */
+void
+charset_init(charset *cs, const char *set)
+{
+  const unsigned char *p;
+  int c;
+
+  memset(cs, 0, sizeof *cs);
+  if (!set) set = "";
+
+  for (p = (const unsigned char *) set; (c = *p); p++) {
+    if (HAS(cs, c)) continue; /* duplicate */
+    cs->bits[c >> 3] |= 1 << (c & 7);
+    if (c < 128) cs->lo[c & 15] |= 1 << (c >> 4);
+    else cs->hi[c & 15] |= 1 << ((c >> 4) - 8);
+    if (cs->nmembers < 16) cs->members[cs->nmembers] = (unsigned char) c;
+    cs->nmembers++;
+  }
+}
+
+#if defined(__SANITIZE_ADDRESS__)
+#define SIMD 0
+#elif defined(__SSSE3__)
+#define SIMD 1
+static unsigned
+members16(const unsigned char *p, const charset *cs)
+{ /* bit i set iff p[i] is in cs */
+  const __m128i bitlut = _mm_setr_epi8(1, 2, 4, 8, 16, 32, 64, (char) 128,
+                                       1, 2, 4, 8, 16, 32, 64, (char) 128);
+  __m128i v = _mm_load_si128((const __m128i *) p);
+  __m128i lo = _mm_and_si128(v, _mm_set1_epi8((char) 0x8F));
+  __m128i hi = _mm_and_si128(_mm_srli_epi16(v, 4), _mm_set1_epi8(0x0F));
+  __m128i row = _mm_or_si128(
+    _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *) cs->lo), lo),
+    _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *) cs->hi),
+                     _mm_xor_si128(lo, _mm_set1_epi8((char) 0x80))));
+  __m128i bit = _mm_shuffle_epi8(bitlut, hi);
+  return _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_and_si128(row, bit), bit));
+}
+#elif defined(__SSE2__)
+#define SIMD 1
+static unsigned
+members16(const unsigned char *p, const charset *cs)
+{ /* bit i set iff p[i] is in cs; only if cs has <= 16 members */
+  __m128i v = _mm_load_si128((const __m128i *) p);
+  __m128i m = _mm_setzero_si128();
+  int i;
+  for (i = 0; i < cs->nmembers; i++)
+    m = _mm_or_si128(m, _mm_cmpeq_epi8(v, _mm_set1_epi8((char) cs->members[i])));
+  return _mm_movemask_epi8(m);
+}
+#endif
+
+#if SIMD
+static unsigned
+zeros16(const unsigned char *p)
+{ /* bit i set iff p[i] is \0 */
+  __m128i v = _mm_load_si128((const __m128i *) p);
+  return _mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_setzero_si128()));
+}
+
+static int
+lowbit(unsigned m)
+{ /* index of lowest set bit in m, m != 0 */
+#if defined(__GNUC__)
+  return __builtin_ctz(m);
+#else
+  int i;
+  for (i = 0; !(m & 1); m >>= 1) i++;
+  return i;
+#endif
+}
+#endif
+
+/** Scan prefix of s consisting only of bytes in cs (like strspn) */
+int
+scanset_while(const char *s, const charset *cs)
+{
+  const unsigned char *p = (const unsigned char *) s;
+
+  if (!s || !cs) return 0;
+
+#if SIMD
+#if !defined(__SSSE3__)
+  if (cs->nmembers <= 16)
+#endif
+  {
+    for (; (uintptr_t) p % ALIGN; p++)
+      if (!HAS(cs, *p)) return (const char *) p - s;
+    for (;; p += ALIGN) { /* \0 is not a member */
+      unsigned m = ~members16(p, cs) & 0xFFFF;
+      if (m) return (const char *) p + lowbit(m) - s;
+    }
+  }
+#endif
+
+  while (HAS(cs, *p)) p++;
+  return (const char *) p - s; /* #bytes scanned */
+}
+
+/** Scan prefix of s consisting of bytes not in cs (like strcspn) */
+int
+scanset_until(const char *s, const charset *cs)
+{
+  const unsigned char *p = (const unsigned char *) s;
+
+  if (!s || !cs) return 0;
+
+#if SIMD
+#if !defined(__SSSE3__)
+  if (cs->nmembers <= 16)
+#endif
+  {
+    for (; (uintptr_t) p % ALIGN; p++)
+      if (!*p || HAS(cs, *p)) return (const char *) p - s;
+    for (;; p += ALIGN) {
+      unsigned m = members16(p, cs) | zeros16(p);
+      if (m) return (const char *) p + lowbit(m) - s;
+    }
+  }
+#endif
+
+  while (*p && !HAS(cs, *p)) p++;
+  return (const char *) p - s; /* #bytes scanned */
+}
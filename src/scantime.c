@@ -5,7 +5,8 @@
  *  Update only tm_hour, tm_min, tm_sec;
  *  leave all other tm fields untouched.
  *
- *  TODO Scan optional time offset from GMT (like Z or +0200)
+ *  The offset from UTC that may follow (like Z or +0200)
+ *  is scanned separately by scanzone().
  *
  *  Return number of bytes scanned, zero on error.
  */
@@ -39,17 +40,5 @@ scantime(const char *s, struct tm *tp)
     tp->tm_sec = t;
   }
 
-#if 0
-  /* scan offset from GMT */
-  while ((*p == ' ') || (*p == '\t')) ++p;
-  if (*p == '+') sign = 1; else if (*p == '-') sign = -1; else return 0;
-  ++p;
-  c = (unsigned char) (*p++ - '0'); if (c > 9) return 0; z = c;
-  c = (unsigned char) (*p++ - '0'); if (c > 9) return 0; z = z*10 + c;
-  c = (unsigned char) (*p++ - '0'); if (c > 9) return 0; z = z*6 + c;
-  c = (unsigned char) (*p++ - '0'); if (c > 9) return 0; z = z*10 + c;
-  if (offset) *offset = z * sign;
-#endif
-
   return p - s;  /* #chars scanned */
 }
@@ -1,18 +1,18 @@
 #include "scan.h"
 
-/** Scan an unsigned int in decimal notation */
+#include <limits.h>
+#include <stdint.h>
+
+/** Scan an unsigned int in decimal notation; zero if out of range */
 int
 scanuint(const char *s, unsigned int *pval)
 {
-  const char *p;
-  unsigned int val;
-
-  if (!s) return 0;
+  uint64_t val;
+  int n;
 
-  for (p=s, val=0; '0' <= *p && *p <= '9'; p++) {
-    val = 10 * val + (*p - '0');
-  }
+  if ((n = scanuint64(s, &val)) == 0) return 0;
+  if (val > UINT_MAX) return 0; /* overflow */
 
-  if (pval) *pval = val;
-  return p - s; /* #bytes scanned */
+  if (pval) *pval = (unsigned int) val;
+  return n; /* #bytes scanned */
 }
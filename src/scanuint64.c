@@ -0,0 +1,96 @@
+#include "scan.h"
+
+#include <stdint.h>
+
+/* SWAR (SIMD within a register) digit scanning: load 8 chars
+ * into a 64 bit word (first char in the low byte), find how many
+ * of them are leading digits, and convert up to 8 digits with
+ * three multiplications instead of one per digit.
+ *
+ * The 8 byte load may read beyond the terminating \0 of s; this
+ * is harmless as long as it does not cross a page boundary, so
+ * near the end of a (4K) page we scan byte by byte. AddressSanitizer
+ * does not know this and reports the read, so with it we never do.
+ */
+
+#define PAGESIZE 4096
+#if defined(__SANITIZE_ADDRESS__)
+#define CANLOAD8(p) 0
+#else
+#define CANLOAD8(p) (((uintptr_t) (p) & (PAGESIZE-1)) <= PAGESIZE-8)
+#endif
+#define ONES UINT64_C(0x0101010101010101)
+
+static uint64_t
+load8(const char *s)
+{ /* compilers turn this into a single load on little endian */
+  const unsigned char *p = (const unsigned char *) s;
+  return (uint64_t) p[0]       | (uint64_t) p[1] <<  8 |
+         (uint64_t) p[2] << 16 | (uint64_t) p[3] << 24 |
+         (uint64_t) p[4] << 32 | (uint64_t) p[5] << 40 |
+         (uint64_t) p[6] << 48 | (uint64_t) p[7] << 56;
+}
+
+static int
+ndigits(uint64_t v)
+{ /* number of leading digits in v (0..8) */
+  uint64_t x, y;
+  int n;
+  /* byte of x is zero iff byte of v is 0x30..0x39 */
+  x = ((v & 0xF0*ONES) | (((v + 0x06*ONES) & 0xF0*ONES) >> 4)) ^ 0x33*ONES;
+  /* set high bit of each non-zero byte */
+  y = (((x & 0x7F*ONES) + 0x7F*ONES) | x) & 0x80*ONES;
+  if (!y) return 8;
+#if defined(__GNUC__)
+  n = __builtin_ctzll(y) / 8;
+#else
+  for (n = 0; !(y & 0x80); y >>= 8) n++;
+#endif
+  return n;
+}
+
+static uint64_t
+parse8(uint64_t v)
+{ /* convert 8 digits (first char in low byte) to their value */
+  v -= 0x30*ONES;
+  v = (v * 10) + (v >> 8); /* pairs of digits */
+  v = (((v & UINT64_C(0x000000FF000000FF)) * (100 + (UINT64_C(1000000) << 32))) +
+       (((v >> 16) & UINT64_C(0x000000FF000000FF)) * (1 + (UINT64_C(10000) << 32)))) >> 32;
+  return v;
+}
+
+static const uint64_t tenpow[9] = {
+  1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000
+};
+
+/** Scan a uint64_t in decimal notation; return zero on overflow */
+int
+scanuint64(const char *s, uint64_t *pval)
+{
+  const char *p;
+  uint64_t val, v;
+  int n;
+
+  if (!s) return 0;
+
+  for (p = s, val = 0; ; p += n) {
+    if (CANLOAD8(p)) {
+      v = load8(p);
+      n = ndigits(v);
+      if (n == 0) break;
+      /* shift digits to the high end: low bytes become leading zeros */
+      v = parse8(n < 8 ? (v << (64 - 8*n)) | (0x30*ONES >> 8*n) : v);
+    }
+    else { /* near end of page */
+      for (n = 0, v = 0; n < 8 && '0' <= p[n] && p[n] <= '9'; n++)
+        v = 10 * v + (p[n] - '0');
+      if (n == 0) break;
+    }
+    if (val > (UINT64_MAX - v) / tenpow[n]) return 0; /* overflow */
+    val = val * tenpow[n] + v;
+    if (n < 8) { p += n; break; }
+  }
+
+  if (pval) *pval = val;
+  return p - s; /* #bytes scanned */
+}
@@ -1,18 +1,18 @@
 #include "scan.h"
 
-/** Scan an unsigned long in decimal notation */
+#include <limits.h>
+#include <stdint.h>
+
+/** Scan an unsigned long in decimal notation; zero if out of range */
 int
 scanulong(const char *s, unsigned long *pval)
 {
-  const char *p;
-  unsigned long val;
-
-  if (!s) return 0;
+  uint64_t val;
+  int n;
 
-  for (p=s, val=0; '0'<=*p && *p<='9'; p++) {
-    val = 10 * val + (*p - '0');
-  }
+  if ((n = scanuint64(s, &val)) == 0) return 0;
+  if (val > ULONG_MAX) return 0; /* overflow */
 
-  if (pval) *pval = val;
-  return p - s; /* #bytes scanned */
+  if (pval) *pval = (unsigned long) val;
+  return n; /* #bytes scanned */
 }
@@ -0,0 +1,49 @@
+#include "scan.h"
+
+#define DIGIT(c) ((unsigned) ((unsigned char) (c) - '0'))
+
+/** Scan an ISO 8601 time zone designator: Z for UTC or an
+ *  offset from UTC like +02:00, +0200, +02, or -05:30.
+ *  Store the offset in minutes east of UTC into *offset.
+ *
+ *  Return number of bytes scanned, zero on error.
+ */
+int
+scanzone(const char *s, int *offset)
+{
+  const char *p;
+  unsigned h, m;
+  int sign;
+
+  if (!s) return 0;
+
+  p = s;
+
+  if (*p == 'Z' || *p == 'z') {
+    if (offset) *offset = 0;
+    return 1;
+  }
+
+  if (*p == '+') sign = 1; else if (*p == '-') sign = -1; else return 0;
+  ++p;
+
+  if (DIGIT(p[0]) > 9 || DIGIT(p[1]) > 9) return 0;
+  h = DIGIT(p[0])*10 + DIGIT(p[1]);
+  p += 2;
+
+  if (*p == ':') { /* +hh:mm */
+    if (DIGIT(p[1]) > 5 || DIGIT(p[2]) > 9) return 0;
+    m = DIGIT(p[1])*10 + DIGIT(p[2]);
+    p += 3;
+  }
+  else if (DIGIT(p[0]) <= 5 && DIGIT(p[1]) <= 9) { /* +hhmm */
+    m = DIGIT(p[0])*10 + DIGIT(p[1]);
+    p += 2;
+  }
+  else m = 0; /* +hh */
+
+  if (h > 23) return 0;
+
+  if (offset) *offset = sign * (int) (h*60 + m);
+  return p - s;  /* #chars scanned */
+}
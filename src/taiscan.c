@@ -0,0 +1,98 @@
+#include "myutils.h"
+#include "scan.h"
+
+#include <stdint.h>
+
+#define TAI64 (UINT64_C(1) << 62) /* label for 1970-01-01 00:00:00 TAI */
+
+static size_t
+scan(const char *s, uint64_t *pt, int32_t *nanos)
+{ /* scan label into seconds since TAI64 and nanos */
+  unsigned char label[12];
+  uint64_t t = 0;
+  uint32_t n = 0;
+  int i;
+
+  if (!s || *s != '@') return 0;
+  if (hexdecode(label, s+1, sizeof label) != 2 * sizeof label) return 0;
+
+  for (i = 0; i < 8; i++) t = (t << 8) | label[i];
+  for (i = 8; i < 12; i++) n = (n << 8) | label[i];
+
+  if (t >> 63 || n > 999999999) return 0; /* reserved, invalid */
+
+  *pt = t - TAI64;
+  if (nanos) *nanos = (int32_t) n;
+
+  return TAISTAMPLEN; /* #bytes scanned */
+}
+
+/** Scan an external TAI64N label (@ and 24 hex digits, with
+ *  TAI = UTC + 10 s, as daemontools does) into UTC seconds
+ *  since the epoch and nanoseconds; return #bytes scanned
+ *  (always TAISTAMPLEN), zero on error */
+size_t
+taiscan(const char *s, int64_t *secs, int32_t *nanos)
+{
+  uint64_t t;
+  if (!scan(s, &t, nanos)) return 0;
+  if (secs) *secs = (int64_t) t - 10;
+  return TAISTAMPLEN;
+}
+
+/** Like taiscan, but for true TAI labels (leap seconds counted) */
+size_t
+taiscan_leaps(const char *s, int64_t *secs, int32_t *nanos)
+{
+  uint64_t t;
+  if (!scan(s, &t, nanos)) return 0;
+  if (secs) *secs = tai2utc((int64_t) t);
+  return TAISTAMPLEN;
+}
+
+/** Convert n TAI64N labels tai[i] to UTC stamps in utc[i]
+ *  (with given separator and #digits, zero terminated, or
+ *  empty if the label does not scan); return #converted */
+size_t
+tai2utcv(const char *const tai[], size_t n, char *const utc[], char sep, int digits)
+{
+  size_t i, k, ok = 0;
+  int64_t t;
+  int32_t ns;
+
+  for (i = 0; i < n; i++) {
+    k = 0;
+    if (taiscan(tai[i], &t, &ns)) {
+      k = utcformat(utc[i], t, ns, sep, digits);
+      ok++;
+    }
+    utc[i][k] = '\0';
+  }
+
+  return ok; /* #labels converted */
+}
+
+/** Convert n UTC stamps utc[i] of length len[i] (or zero
+ *  terminated if len is null) to TAI64N labels in tai[i]
+ *  (zero terminated, or empty if the stamp does not scan);
+ *  return #converted */
+size_t
+utc2taiv(const char *const utc[], const size_t len[], size_t n, char *const tai[])
+{
+  size_t i, k, ok = 0;
+  int64_t t;
+  int32_t ns;
+
+  for (i = 0; i < n; i++) {
+    if (len) k = len[i];
+    else for (k = 0; utc[i] && k < 64 && utc[i][k]; k++) {}
+    if (utcscan_epoch(utc[i], k, &t, &ns)) {
+      k = taiformat(tai[i], t, ns);
+      ok++;
+    }
+    else k = 0;
+    tai[i][k] = '\0';
+  }
+
+  return ok; /* #stamps converted */
+}
@@ -0,0 +1,122 @@
+/* required for clock_gettime */
+#define _POSIX_C_SOURCE 200112L
+
+#include "myutils.h"
+#include "print.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <time.h>
+
+/* TAISTAMP: @4000000042d77da200000000 (TAI64N)
+ *
+ * An external TAI64N label is an @ followed by 24 hex digits:
+ * 2^62 plus the TAI seconds since 1970-01-01 00:00:00 TAI as
+ * 8 bytes, and the nanoseconds as 4 bytes, both big endian.
+ * Labels sort and compare as plain strings, and producing one
+ * takes a table lookup and a hex encode, no calendar math.
+ *
+ * TAI runs ahead of UTC by 10 seconds (in 1972) plus one
+ * second for each leap second inserted since. The labels of
+ * daemontools (tai64n, multilog) assume a fixed 10 seconds,
+ * and so do ours, so that they sort together and tai64nlocal
+ * shows them right. The _leaps variants take leap seconds into
+ * account (from the table below) and give true TAI labels.
+ */
+
+#define TAI64 (UINT64_C(1) << 62) /* label for 1970-01-01 00:00:00 TAI */
+
+/* UTC seconds since the epoch at which TAI-UTC went up by one
+ * (from 10 before 1972-07-01 to 37 since 2017-01-01; no more
+ * leap seconds were announced until at least the end of 2026) */
+static const int64_t leaps[] = {
+  78796800,   /* 1972-07-01 */
+  94694400,   /* 1973-01-01 */
+  126230400,  /* 1974-01-01 */
+  157766400,  /* 1975-01-01 */
+  189302400,  /* 1976-01-01 */
+  220924800,  /* 1977-01-01 */
+  252460800,  /* 1978-01-01 */
+  283996800,  /* 1979-01-01 */
+  315532800,  /* 1980-01-01 */
+  362793600,  /* 1981-07-01 */
+  394329600,  /* 1982-07-01 */
+  425865600,  /* 1983-07-01 */
+  489024000,  /* 1985-07-01 */
+  567993600,  /* 1988-01-01 */
+  631152000,  /* 1990-01-01 */
+  662688000,  /* 1991-01-01 */
+  709948800,  /* 1992-07-01 */
+  741484800,  /* 1993-07-01 */
+  773020800,  /* 1994-07-01 */
+  820454400,  /* 1996-01-01 */
+  867715200,  /* 1997-07-01 */
+  915148800,  /* 1999-01-01 */
+  1136073600, /* 2006-01-01 */
+  1230768000, /* 2009-01-01 */
+  1341100800, /* 2012-07-01 */
+  1435708800, /* 2015-07-01 */
+  1483228800  /* 2017-01-01 */
+};
+
+#define NLEAPS ((int) (sizeof leaps / sizeof *leaps))
+
+/** Convert UTC seconds since the epoch to TAI seconds
+ *  since 1970-01-01 00:00:00 TAI */
+int64_t
+utc2tai(int64_t secs)
+{
+  int i = NLEAPS; /* recent times first */
+  while (i > 0 && secs < leaps[i-1]) i--;
+  return secs + 10 + i;
+}
+
+/** Convert TAI seconds to UTC seconds since the epoch;
+ *  an inserted leap second maps to the second after it */
+int64_t
+tai2utc(int64_t tai)
+{
+  int i = NLEAPS;
+  while (i > 0 && tai < leaps[i-1] + 10 + i) i--;
+  return tai - 10 - i;
+}
+
+static size_t
+label(char buf[], uint64_t t, int32_t nanos)
+{ /* the label for TAI64 + t seconds and nanos */
+  unsigned char bytes[12];
+  uint32_t n = (uint32_t) nanos;
+  int i;
+
+  for (i = 7; i >= 0; i--, t >>= 8) bytes[i] = (unsigned char) t;
+  for (i = 11; i >= 8; i--, n >>= 8) bytes[i] = (unsigned char) n;
+
+  buf[0] = '@';
+  return 1 + hexencode(buf+1, bytes, sizeof bytes);
+}
+
+/** Format UTC secs and nanos (0..999999999) since the epoch
+ *  as an external TAI64N label (TAI = UTC + 10 s, as daemontools
+ *  does); return #chars written */
+size_t
+taiformat(char buf[], int64_t secs, int32_t nanos)
+{
+  return label(buf, TAI64 + (uint64_t) (secs + 10), nanos);
+}
+
+/** Like taiformat, but true TAI (leap seconds counted) */
+size_t
+taiformat_leaps(char buf[], int64_t secs, int32_t nanos)
+{
+  return label(buf, TAI64 + (uint64_t) utc2tai(secs), nanos);
+}
+
+/** Write the current time as a TAI64N label into buf,
+ *  which must be at least TAISTAMPLEN chars long */
+size_t
+taistamp(char buf[])
+{
+  struct timespec ts;
+  if (clock_gettime(CLOCK_REALTIME, &ts) < 0) abort();
+  return taiformat(buf, ts.tv_sec, ts.tv_nsec);
+}
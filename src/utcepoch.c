@@ -0,0 +1,161 @@
+#include "myutils.h"
+#include "scan.h"
+
+#include <stdint.h>
+
+/* Fast path for the fixed layout yyyy-mm-ddThh:mm:ss[.fffffffff]Z
+ * (or with an offset like +02:00 instead of the Z), converting
+ * directly to seconds since the epoch (like timegm(3), but without
+ * going through struct tm and the C library).
+ *
+ * The date and time fields are loaded as three 64 bit words (SWAR):
+ *
+ *   a = "yyyy-mm-"   b = "ddThh:mm"   c = "hh:mm:ss"
+ *
+ * and all digits and separators are validated with a few masks.
+ */
+
+#define ONES UINT64_C(0x0101010101010101)
+
+static uint64_t
+load8(const char *s)
+{ /* compilers turn this into a single load on little endian */
+  const unsigned char *p = (const unsigned char *) s;
+  return (uint64_t) p[0]       | (uint64_t) p[1] <<  8 |
+         (uint64_t) p[2] << 16 | (uint64_t) p[3] << 24 |
+         (uint64_t) p[4] << 32 | (uint64_t) p[5] << 40 |
+         (uint64_t) p[6] << 48 | (uint64_t) p[7] << 56;
+}
+
+static uint64_t
+nondigits(uint64_t v)
+{ /* byte is zero iff byte of v is a digit 0..9 */
+  return ((v & 0xF0*ONES) | (((v + 0x06*ONES) & 0xF0*ONES) >> 4)) ^ 0x33*ONES;
+}
+
+#define BYTE(x, i) ((int) (((x) >> (8*(i))) & 0xFF))
+#define TWO(x, i) (BYTE(x, i) * 10 + BYTE(x, i+1)) /* two digit value */
+
+/* Digit masks and separators for the three words */
+#define ADIGITS UINT64_C(0x00FFFF00FFFFFFFF)     /* yyyy-mm- */
+#define ASEPS   UINT64_C(0x2D00002D00000000)     /*     -  - */
+#define BDIGITS UINT64_C(0x000000000000FFFF)     /* dd       */
+#define CDIGITS UINT64_C(0xFFFF00FFFF00FFFF)     /* hh:mm:ss */
+#define CSEPS   UINT64_C(0x00003A00003A0000)     /*   :  :   */
+
+/** Days since 1970-01-01 of the given date in the proleptic
+ *  Gregorian calendar (H. Hinnant's days_from_civil algorithm);
+ *  month is 1..12, day is 1..31 */
+int64_t
+utcdays(int64_t year, int month, int day)
+{
+  int64_t era, yoe, doy, doe;
+  year -= month <= 2;
+  era = (year >= 0 ? year : year - 399) / 400;
+  yoe = year - era * 400;                                 /* 0..399 */
+  doy = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1; /* 0..365 */
+  doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;            /* 0..146096 */
+  return era * 146097 + doe - 719468;
+}
+
+/** Number of days in the given month (1..12) of year */
+int
+utcmdays(int64_t year, int month)
+{
+  static const unsigned char days[12] = {31,28,31,30,31,30,31,31,30,31,30,31};
+  if (month == 2 && year % 4 == 0 && (year % 100 != 0 || year % 400 == 0))
+    return 29;
+  return days[month-1];
+}
+
+/** Scan a timestamp yyyy-mm-ddThh:mm:ss[.fffffffff]Z from
+ *  s[0..len) into seconds since the epoch and nanoseconds (any
+ *  digits beyond nanoseconds are ignored); instead of Z there
+ *  may be an offset from UTC (like +02:00 or -0530), which is
+ *  subtracted; return #bytes scanned, zero on error */
+size_t
+utcscan_epoch(const char *s, size_t len, int64_t *secs, int32_t *nanos)
+{
+  uint64_t a, b, c;
+  int year, month, day, hour, min, sec;
+  int32_t frac;
+  size_t i;
+  int k, offset;
+  char zone[8];
+
+  if (!s || len < 20) return 0;
+
+  a = load8(s);
+  b = load8(s+8);
+  c = load8(s+11);
+
+  if ((nondigits(a) & ADIGITS) | (nondigits(b) & BDIGITS) | (nondigits(c) & CDIGITS))
+    return 0;
+  if ((a & ~ADIGITS) != ASEPS || (c & ~CDIGITS) != CSEPS)
+    return 0;
+  switch (BYTE(b, 2)) {
+    case 'T': case 't': case ' ': break;
+    default: return 0;
+  }
+
+  /* digits to values (mask separators first to avoid borrows) */
+  a = (a & ADIGITS) - (0x30*ONES & ADIGITS);
+  b = (b & BDIGITS) - (0x30*ONES & BDIGITS);
+  c = (c & CDIGITS) - (0x30*ONES & CDIGITS);
+
+  year = TWO(a, 0) * 100 + TWO(a, 2);
+  month = TWO(a, 5);
+  day = TWO(b, 0);
+  hour = TWO(c, 0);
+  min = TWO(c, 3);
+  sec = TWO(c, 6);
+
+  if (month < 1 || month > 12 || day < 1 || day > utcmdays(year, month))
+    return 0;
+  if (hour > 23 || min > 59 || sec > 60) /* allow a leap second */
+    return 0;
+
+  i = 19;
+  frac = 0;
+  if (s[i] == '.') {
+    for (k = 0, ++i; i < len && '0' <= s[i] && s[i] <= '9'; i++, k++)
+      if (k < 9) frac = frac * 10 + (s[i] - '0');
+    if (k == 0) return 0;
+    for (; k < 9; k++) frac *= 10;
+  }
+
+  /* Z or offset: at most 6 bytes, but s need not be terminated */
+  for (k = 0; k < 6 && i + k < len; k++) zone[k] = s[i+k];
+  zone[k] = '\0';
+  if ((k = scanzone(zone, &offset)) == 0) return 0;
+  i += k;
+
+  if (secs) *secs = utcdays(year, month, day) * 86400 +
+                    hour * 3600 + (min - offset) * 60 + sec;
+  if (nanos) *nanos = frac;
+
+  return i; /* #bytes scanned */
+}
+
+/** Scan a column of n UTC timestamps s[i] of length len[i] (or
+ *  zero-terminated if len is null); for those that fail to scan,
+ *  set secs[i] to 0 and nanos[i] to -1; return #scanned ok */
+size_t
+utcscan_epochv(const char *const s[], const size_t len[], size_t n,
+               int64_t secs[], int32_t nanos[])
+{
+  size_t i, k, ok = 0;
+  int64_t t;
+  int32_t ns;
+
+  for (i = 0; i < n; i++) {
+    if (len) k = len[i];
+    else for (k = 0; s[i] && k < 64 && s[i][k]; k++) {}
+    if (utcscan_epoch(s[i], k, &t, &ns)) ok++;
+    else t = 0, ns = -1;
+    if (secs) secs[i] = t;
+    if (nanos) nanos[i] = ns;
+  }
+
+  return ok; /* #timestamps scanned */
+}
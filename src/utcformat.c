@@ -0,0 +1,55 @@
+#include "myutils.h"
+
+#include <stdint.h>
+
+/* If year < 1000 or year > 9999 we do not print the
+ * year, but the string "xxxx" to mark the problem
+ * (same as utcstamp).
+ */
+
+#define two(p, x) ((p)[0] = '0' + (x) / 10, (p)[1] = '0' + (x) % 10)
+
+size_t /* format secs and nanos since the epoch as UTC timestamp into buf */
+utcformat(char buf[], int64_t secs, int32_t nanos, char sep, int digits)
+{
+  int64_t days, era, doe, yoe, doy, mp, year;
+  int month, day, rem;
+  char *p = buf;
+
+  /* floor division: secs may be negative */
+  days = secs / 86400;
+  rem = (int) (secs % 86400);
+  if (rem < 0) rem += 86400, days -= 1;
+
+  /* civil from days (H. Hinnant), inverse of utcdays() */
+  days += 719468;
+  era = (days >= 0 ? days : days - 146096) / 146097;
+  doe = days - era * 146097;                                    /* 0..146096 */
+  yoe = (doe - doe/1460 + doe/36524 - doe/146096) / 365;        /* 0..399 */
+  doy = doe - (365*yoe + yoe/4 - yoe/100);                      /* 0..365 */
+  mp = (5*doy + 2) / 153;                                       /* 0..11 */
+  day = (int) (doy - (153*mp + 2)/5 + 1);                       /* 1..31 */
+  month = (int) (mp < 10 ? mp + 3 : mp - 9);                    /* 1..12 */
+  year = yoe + era * 400 + (month <= 2);
+
+  if (year < 1000 || year > 9999) { p[0] = p[1] = p[2] = p[3] = 'x'; }
+  else { two(p, (int) (year / 100)); two(p+2, (int) (year % 100)); }
+  p[4] = '-'; two(p+5, month);
+  p[7] = '-'; two(p+8, day);
+  p[10] = sep ? sep : 'T'; two(p+11, rem / 3600);
+  p[13] = ':'; two(p+14, rem / 60 % 60);
+  p[16] = ':'; two(p+17, rem % 60);
+  p += 19;
+
+  if (digits > 0) {
+    int i, k;
+    if (digits > 9) digits = 9;
+    *p++ = '.';
+    for (i = 9, k = nanos; i > digits; i--) k /= 10;
+    for (i = digits; i > 0; i--, k /= 10) p[i-1] = '0' + k % 10;
+    p += digits;
+  }
+
+  *p++ = 'Z'; /* means UTC */
+  return p - buf; /* #chars printed */
+}
@@ -1,12 +1,38 @@
 #include "myutils.h"
 #include "scan.h"
 
-size_t /* scan a UTC timestamp in ISO8601 format */
+static void
+normalize(struct tm *tp, int offset)
+{ /* subtract offset (minutes east of UTC, |offset| < 24h) */
+  int year = tp->tm_year + 1900;
+  int mins = tp->tm_hour * 60 + tp->tm_min - offset;
+
+  tp->tm_hour = mins / 60;
+  tp->tm_min = mins % 60;
+  if (tp->tm_min < 0) tp->tm_min += 60, tp->tm_hour -= 1;
+
+  if (tp->tm_hour >= 24) { /* next day */
+    tp->tm_hour -= 24;
+    if (++tp->tm_mday > utcmdays(year, tp->tm_mon + 1)) {
+      tp->tm_mday = 1;
+      if (++tp->tm_mon > 11) tp->tm_mon = 0, tp->tm_year += 1;
+    }
+  }
+  else if (tp->tm_hour < 0) { /* previous day */
+    tp->tm_hour += 24;
+    if (--tp->tm_mday < 1) {
+      if (--tp->tm_mon < 0) tp->tm_mon = 11, tp->tm_year -= 1, year -= 1;
+      tp->tm_mday = utcmdays(year, tp->tm_mon + 1);
+    }
+  }
+}
+
+size_t /* scan an ISO8601 timestamp and convert to UTC */
 utcscan(const char *s, struct tm *tp)
 {
   register const char *p;
   struct tm tm;
-  int n;
+  int n, offset;
 
   if (!s) return 0;
 
@@ -28,7 +54,11 @@ utcscan(const char *s, struct tm *tp)
   if ((n = scantime(p, &tm)) == 0) return 0;
   p += n;
 
-  if (*p++ != 'Z') return 0; /* not UTC */
+  /* Z for UTC or an offset like +02:00 */
+  if ((n = scanzone(p, &offset)) == 0) return 0;
+  p += n;
+
+  if (offset) normalize(&tm, offset);
 
   tm.tm_wday = tm.tm_yday = tm.tm_isdst = 0;
   if (tp) *tp = tm;
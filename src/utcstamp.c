@@ -1,6 +1,11 @@
+/* required for clock_gettime */
+#define _POSIX_C_SOURCE 200112L
+
 #include "myutils.h"
 
+#include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
 #include <time.h>
 
 /* UTCSTAMP: 2005-07-15T12:34:56Z */
@@ -58,6 +63,76 @@ utcstamp(char buf[], char sep)
   return p - buf; /* #chars printed */
 }
 
+/* A UTCSTAMP changes only in its last digits from one call to
+ * the next: utcstampx keeps the stamp formatted up to the seconds
+ * in the given cache, formats it from scratch (with utcformat)
+ * only when the minute changes, and otherwise just updates the
+ * two digits of the seconds. The time comes from clock_gettime,
+ * which on Linux is served from the vDSO, without a system call;
+ * for whole seconds, we use the even cheaper coarse clock. The
+ * coarse clock may lag the fine one by a tick, so a stamp could
+ * go back by a second after a call with digits; if the second
+ * read is just one before the cached one, we keep the cached one
+ * (a real step of the clock is still followed).
+ *
+ * The cache is owned by the caller: give each thread its own,
+ * and no locking is needed.
+ */
+
+size_t /* format UTC timestamp with given #digits of fractional seconds */
+utcstampx(struct utcclock *cp, char buf[], char sep, int digits)
+{
+  struct timespec ts;
+  clockid_t clock = CLOCK_REALTIME;
+  int64_t secs, minute;
+  int second;
+  char *p;
+
+#ifdef CLOCK_REALTIME_COARSE
+  if (digits <= 0) clock = CLOCK_REALTIME_COARSE;
+#endif
+  if (clock_gettime(clock, &ts) < 0) abort();
+  secs = ts.tv_sec;
+
+  if (!cp) return utcformat(buf, secs, ts.tv_nsec, sep, digits);
+
+  if (cp->valid && secs + 1 == cp->minute * 60 + cp->second)
+    secs += 1, ts.tv_nsec = 0; /* coarse clock lagging: keep cached */
+
+  minute = secs / 60;
+  second = (int) (secs % 60);
+  if (second < 0) second += 60, minute -= 1;
+
+  if (!cp->valid || minute != cp->minute) {
+    utcformat(cp->stamp, secs, 0, DEFAULT_SEP, 0);
+    cp->minute = minute;
+    cp->second = second;
+    cp->valid = 1;
+  }
+  else if (second != cp->second) {
+    cp->stamp[17] = '0' + second / 10;
+    cp->stamp[18] = '0' + second % 10;
+    cp->second = second;
+  }
+
+  memcpy(buf, cp->stamp, 19);
+  if (sep) buf[10] = sep;
+  p = buf + 19;
+
+  if (digits > 0) {
+    long k = ts.tv_nsec;
+    int i;
+    if (digits > 9) digits = 9;
+    *p++ = '.';
+    for (i = 9; i > digits; i--) k /= 10;
+    for (i = digits; i > 0; i--, k /= 10) p[i-1] = '0' + k % 10;
+    p += digits;
+  }
+
+  *p++ = 'Z'; /* means UTC */
+  return p - buf; /* #chars printed */
+}
+
 #ifdef UTCSTAMP
 #include <stdio.h>
 #include <time.h>
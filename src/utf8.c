@@ -56,7 +56,8 @@ utf8get(const char *p, int *pc)
     c = utf8tab[c & 0x3F];
     /* ingest continuation bytes (10xx xxxx) */
     while ((*p & 0xC0) == 0x80) {
-      c = (c << 6) + ((unsigned char) *p++ & 0x3F);
+      c = (int) ((unsigned) c << 6); /* no overflow if there are many */
+      c += (unsigned char) *p++ & 0x3F;
     }
     /* replace overlong 7bit encodings and surrogate pairs */
     if (c < 0x80 || (0xD800 <= c && c <= 0xDFFF)) {
@@ -115,9 +116,9 @@ utf8len(const char *z, size_t len)
   else end = (const unsigned char *)(-1);
   assert(p <= end);
 
-  for (n = 0; *p && p < end; n++) {
+  for (n = 0; p < end && *p; n++) {
     if (*p++ >= 0xC0) {
-      while ((*p & 0xC0) == 0x80) p++;
+      while (p < end && (*p & 0xC0) == 0x80) p++;
     }
   }
   return n;
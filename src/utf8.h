@@ -21,8 +21,9 @@ extern size_t utf8len(const char *z, size_t len);
   c = (unsigned char) *z++;                          \
   if (c >= 0xC0) {                                   \
     c = utf8tab[c & 0x3F];                           \
-    while ((*z & 0xC0) == 0x80 && z < end) {         \
-      c = (c << 6) + ((unsigned char) *z++ & 0x3F);  \
+    while (z < end && (*z & 0xC0) == 0x80) {         \
+      c = (int) ((unsigned) c << 6);                 \
+      c += (unsigned char) *z++ & 0x3F;              \
     }                                                \
     if (c < 0x80 || (0xD800 <= c && c <= 0xDFFF)) {  \
       c = 0xFFFD; /* replacement character */        \
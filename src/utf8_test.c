@@ -3,6 +3,8 @@
 #include "test.h"
 #include "utf8.h"
 
+#include <stdlib.h>
+
 
 static void
 encode(const int *pu, char *buf, size_t buflen)
@@ -33,6 +35,15 @@ decode(const char *u, int *buf, int buflen)
   buf[i] = 0;
 }
 
+static char *
+copyn(const char *s, size_t n)
+{ /* not terminated */
+  char *p = malloc(n);
+  if (!p) { perror("utf8_test"); abort(); }
+  memcpy(p, s, n);
+  return p;
+}
+
 void
 utf8_test(int *pnumpass, int *pnumfail)
 {
@@ -51,7 +62,7 @@ utf8_test(int *pnumpass, int *pnumfail)
   utf8get(buf, &c);
   TEST("decode EF BF BD", c==0xFFFD);
 
-  utf8put(0x1D11E, buf);
+  buf[utf8put(0x1D11E, buf)] = 0;
   utf8get(buf, &c);
   TEST("U+1D11E 𝄞", c == 0x1D11E);
 
@@ -79,6 +90,40 @@ utf8_test(int *pnumpass, int *pnumfail)
   TEST("decode", codes[0]==0x2022 && codes[1]==0x41F && codes[2]==0x451 &&
     codes[3]==0x442 && codes[4]==0x440 && codes[5]==0x1D11E && codes[6]==0);
 
+  /* bounds and long runs, on copies of exact size, so that
+     AddressSanitizer reports reading beyond them */
+  {
+    static const char long_run[] = "\xF0\x80\x80\x80\x80\x80\x80\x80\x80\x80\x80\x81";
+    const char *p, *end;
+    char *x;
+
+    x = copyn("\xC3\xBC\xC3", 3); /* ü and a lead byte */
+    TEST("utf8len (limit mid-char)", 2 == utf8len(x, 3));
+    free(x);
+
+    x = copyn("a\xE2", 2);
+    p = x, end = x + 2;
+    UTF8_GET(c, p, end);
+    UTF8_GET(c, p, end);
+    TEST("UTF8_GET (lead byte at end)", p == end && c == 0xFFFD);
+    free(x);
+
+    x = copyn("\xE2\x82", 2); /* € cut short */
+    p = x, end = x + 2;
+    UTF8_GET(c, p, end);
+    TEST("UTF8_GET (end mid-char)", p == end);
+    free(x);
+
+    /* more continuation bytes than fit into an int: no overflow,
+       all are consumed, and the (overlong) result is replaced */
+    TEST("utf8get (long run)", utf8get(long_run, &c) == sizeof long_run - 1 && c == 0xFFFD);
+    x = copyn(long_run, sizeof long_run - 1);
+    p = x, end = x + sizeof long_run - 1;
+    UTF8_GET(c, p, end);
+    TEST("UTF8_GET (long run)", p == end && c == 0xFFFD);
+    free(x);
+  }
+
   if (pnumpass) *pnumpass += numpass;
   if (pnumfail) *pnumfail += numfail;
 }
@@ -0,0 +1,279 @@
+#include "varint.h"
+
+#if defined(__SSSE3__)
+#include <tmmintrin.h>
+#endif
+
+/* Varints are LEB128 (as in protocol buffers): 7 bits per byte,
+ * least significant group first, the high bit set on all bytes but
+ * the last. Zigzag maps signed to unsigned so that values of small
+ * magnitude get short varints: n => 2n for n >= 0, -n => 2n-1.
+ *
+ * Stream VByte (Lemire, Kurz, Rupp 2017) stores n 32 bit values as
+ * (n+3)/4 control bytes, followed by the data bytes. Each control
+ * byte holds four 2 bit lengths (1..4 bytes, low bits first), and
+ * each value is stored in that many bytes, little endian. Since
+ * the lengths are separate from the data, decoding needs no branch
+ * per value: with SSSE3, one PSHUFB per control byte moves the
+ * (up to 16) data bytes of four values into place, using a table of
+ * 256 shuffle masks. Near the end of the input (where a 16 byte load
+ * could go past it) the scalar loop takes over.
+ */
+
+/** Number of bytes in the varint of v (1..10) */
+size_t
+varint_len(uint64_t v)
+{
+  size_t n = 1;
+  while (v >= 0x80) v >>= 7, n++;
+  return n;
+}
+
+/** Store the varint of v into buf; return #bytes */
+size_t
+varint_put(void *buf, uint64_t v)
+{
+  unsigned char *p = (unsigned char *) buf;
+  size_t n;
+
+  if (!p) return varint_len(v);
+  for (n = 0; v >= 0x80; v >>= 7)
+    p[n++] = (unsigned char) (v | 0x80);
+  p[n++] = (unsigned char) v;
+  return n;
+}
+
+/** Read a varint from buf[0..len) into *pv; return #bytes read,
+ *  or 0 if truncated or too long for 64 bits */
+size_t
+varint_get(const void *buf, size_t len, uint64_t *pv)
+{
+  const unsigned char *p = (const unsigned char *) buf;
+  uint64_t v = 0;
+  size_t i;
+
+  if (!p) return 0;
+  if (len > 0 && p[0] < 0x80) { /* fast path */
+    if (pv) *pv = p[0];
+    return 1;
+  }
+  for (i = 0; i < len && i < VARINT_MAX; i++) {
+    v |= (uint64_t) (p[i] & 0x7F) << 7*i;
+    if (p[i] < 0x80) {
+      if (i == VARINT_MAX-1 && p[i] > 1) return 0; /* overflow */
+      if (pv) *pv = v;
+      return i+1;
+    }
+  }
+  return 0; /* truncated or too long */
+}
+
+/** Map signed to unsigned: 0, -1, 1, -2, ... => 0, 1, 2, 3, ... */
+uint64_t
+zigzag(int64_t v)
+{
+  return ((uint64_t) v << 1) ^ (v < 0 ? UINT64_MAX : 0);
+}
+
+/** The inverse of zigzag */
+int64_t
+unzigzag(uint64_t u)
+{
+  uint64_t v = (u >> 1) ^ (0 - (u & 1));
+  return v <= INT64_MAX ? (int64_t) v : -(int64_t) (~v) - 1;
+}
+
+/** Store the zigzag varint of v into buf; return #bytes */
+size_t
+svarint_put(void *buf, int64_t v)
+{
+  return varint_put(buf, zigzag(v));
+}
+
+/** Read a zigzag varint; return like varint_get */
+size_t
+svarint_get(const void *buf, size_t len, int64_t *pv)
+{
+  uint64_t u;
+  size_t n = varint_get(buf, len, &u);
+  if (n && pv) *pv = unzigzag(u);
+  return n;
+}
+
+/* Stream VByte */
+
+#define LEN(x) ((x) < 1u<<8 ? 1u : (x) < 1u<<16 ? 2u : (x) < 1u<<24 ? 3u : 4u)
+
+/** Encode the n values in[] into buf (at most SVB_MAX(n) bytes);
+ *  return #bytes */
+size_t
+svb_encode(void *buf, const uint32_t in[], size_t n)
+{
+  unsigned char *ctl = (unsigned char *) buf;
+  unsigned char *data;
+  unsigned code = 0, len, k;
+  size_t i, size = (n+3)/4;
+
+  if (!ctl) {
+    for (i = 0; i < n; i++) size += LEN(in[i]);
+    return size;
+  }
+  data = ctl + size;
+  for (i = 0; i < n; i++) {
+    uint32_t x = in[i];
+    len = LEN(x);
+    code |= (len-1) << 2*(i&3);
+    for (k = 0; k < len; k++, x >>= 8) *data++ = (unsigned char) x;
+    if ((i&3) == 3 || i+1 == n) {
+      ctl[i/4] = (unsigned char) code;
+      code = 0;
+    }
+  }
+  return (size_t) (data - ctl);
+}
+
+#if defined(__SSSE3__)
+/* shuffle masks and data lengths, by control byte c */
+#define L(c,k) ((((c) >> 2*(k)) & 3) + 1)
+#define O(c,k) (((k) > 0 ? L(c,0) : 0) + ((k) > 1 ? L(c,1) : 0) + ((k) > 2 ? L(c,2) : 0))
+#define B(c,k,j) ((j) < L(c,k) ? O(c,k) + (j) : 0x80)
+#define M(c) {B(c,0,0), B(c,0,1), B(c,0,2), B(c,0,3), B(c,1,0), B(c,1,1), B(c,1,2), B(c,1,3), \
+              B(c,2,0), B(c,2,1), B(c,2,2), B(c,2,3), B(c,3,0), B(c,3,1), B(c,3,2), B(c,3,3)}
+#define N(c) (L(c,0) + L(c,1) + L(c,2) + L(c,3))
+#define R4(X,c) X(c), X(c+1), X(c+2), X(c+3)
+#define R16(X,c) R4(X,c), R4(X,c+4), R4(X,c+8), R4(X,c+12)
+#define R64(X,c) R16(X,c), R16(X,c+16), R16(X,c+32), R16(X,c+48)
+
+static const unsigned char shuffles[256][16] = {
+  R64(M,0), R64(M,64), R64(M,128), R64(M,192)
+};
+static const unsigned char lengths[256] = {
+  R64(N,0), R64(N,64), R64(N,128), R64(N,192)
+};
+#endif
+
+/** Decode n values from buf[0..len) into out[]; return #bytes read,
+ *  or 0 if buf is too short (then out[] is undefined) */
+size_t
+svb_decode(uint32_t out[], const void *buf, size_t len, size_t n)
+{
+  const unsigned char *ctl = (const unsigned char *) buf;
+  const unsigned char *data, *end;
+  size_t i = 0;
+  unsigned k, l;
+  uint32_t x;
+
+  if (!ctl || len < (n+3)/4) return 0;
+  data = ctl + (n+3)/4;
+  end = ctl + len;
+
+#if defined(__SSSE3__)
+  for (; i + 4 <= n && end - data >= 16; i += 4) {
+    unsigned c = ctl[i/4];
+    _mm_storeu_si128((__m128i *) (out + i),
+      _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *) data),
+                       _mm_loadu_si128((const __m128i *) shuffles[c])));
+    data += lengths[c];
+  }
+#endif
+  for (; i < n; i++) {
+    l = ((ctl[i/4] >> 2*(i&3)) & 3) + 1;
+    if ((size_t) (end - data) < l) return 0;
+    for (x = 0, k = 0; k < l; k++) x |= (uint32_t) data[k] << 8*k;
+    out[i] = x;
+    data += l;
+  }
+  return (size_t) (data - ctl);
+}
+
+/** Append the varint of v to the strbuf */
+int
+varint_add(strbuf *sp, uint64_t v)
+{
+  if (!strbuf_ready(sp, VARINT_MAX)) return 0; /* nomem */
+  sp->len += varint_put(sp->buf + sp->len, v);
+  sp->buf[sp->len] = '\0';
+  return 1;
+}
+
+/** Append the Stream VByte encoding of in[0..n) to the strbuf */
+int
+svb_add(strbuf *sp, const uint32_t in[], size_t n)
+{
+  if (n > ((size_t) -1) / 8) return 0; /* overflow */
+  if (!strbuf_ready(sp, SVB_MAX(n))) return 0; /* nomem */
+  sp->len += svb_encode(sp->buf + sp->len, in, n);
+  sp->buf[sp->len] = '\0';
+  return 1;
+}
+
+#ifdef DEMO
+/* Compare sizes and decoding speed: decimal text, varints, svb */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "print.h"
+#include "scan.h"
+
+#define COUNT 1000000
+
+static double
+now(void)
+{
+  return (double) clock() / CLOCKS_PER_SEC;
+}
+
+int
+main(int argc, char **argv)
+{
+  uint32_t *in = malloc(COUNT * sizeof *in), *out = malloc(COUNT * sizeof *out);
+  char *text = malloc(COUNT * 11 + 1), *bin = malloc(SVB_MAX(COUNT));
+  uint64_t x = 1, v = 0, sum;
+  size_t i, n, len;
+  unsigned long u;
+  int bits = argc > 1 ? atoi(argv[1]) : 20;
+  double t;
+
+  if (!in || !out || !text || !bin) { perror("varint"); return 1; }
+  if (bits < 1 || bits > 32) bits = 20;
+  for (i = 0; i < COUNT; i++) { /* LCG, values up to 2^bits */
+    x = x * UINT64_C(6364136223846793005) + UINT64_C(1442695040888963407);
+    in[i] = (uint32_t) (x >> 32) >> (32 - bits) >> (x >> 61);
+  }
+  printf("%d values, up to %d bits\n", COUNT, bits);
+
+  for (len = 0, i = 0; i < COUNT; i++) {
+    len += printu(text + len, in[i]);
+    text[len++] = '\n';
+  }
+  text[len] = '\0';
+  t = now();
+  for (sum = 0, n = 0, i = 0; i < COUNT; i++) {
+    n += scanulong(text + n, &u) + 1;
+    sum += u;
+  }
+  printf("text    %8lu bytes %6.2f ns/value (%lx)\n", (unsigned long) len,
+         (now() - t) * 1e9 / COUNT, (unsigned long) sum);
+
+  for (len = 0, i = 0; i < COUNT; i++) len += varint_put(bin + len, in[i]);
+  t = now();
+  for (sum = 0, n = 0, i = 0; i < COUNT; i++) {
+    n += varint_get(bin + n, len - n, &v);
+    sum += v;
+  }
+  printf("varint  %8lu bytes %6.2f ns/value (%lx)\n", (unsigned long) len,
+         (now() - t) * 1e9 / COUNT, (unsigned long) sum);
+
+  len = svb_encode(bin, in, COUNT);
+  t = now();
+  svb_decode(out, bin, len, COUNT);
+  for (sum = 0, i = 0; i < COUNT; i++) sum += out[i];
+  printf("svb     %8lu bytes %6.2f ns/value (%lx)\n", (unsigned long) len,
+         (now() - t) * 1e9 / COUNT, (unsigned long) sum);
+
+  free(in), free(out), free(text), free(bin);
+  return 0;
+}
+#endif
@@ -0,0 +1,45 @@
+#ifndef VARINT_H
+#define VARINT_H
+
+/* Compact binary encodings of integers: LEB128 varints,
+ * zigzag for signed values, and Stream VByte for arrays.
+ * The put/encode functions return the number of bytes written,
+ * even if the buffer is NULL (to determine lengths beforehand);
+ * the get/decode functions return the number of bytes read,
+ * or 0 if the input is truncated or malformed.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "strbuf.h"
+
+#define VARINT_MAX 10  /* max #bytes of a 64 bit varint */
+#define SVB_MAX(n) (((n)+3)/4 + 4*(n))  /* max #bytes for n values */
+
+size_t varint_len(uint64_t v);
+size_t varint_put(void *buf, uint64_t v);
+size_t varint_get(const void *buf, size_t len, uint64_t *pv);
+
+uint64_t zigzag(int64_t v);     /* 0,-1,1,-2,.. => 0,1,2,3,.. */
+int64_t unzigzag(uint64_t u);
+size_t svarint_put(void *buf, int64_t v);
+size_t svarint_get(const void *buf, size_t len, int64_t *pv);
+
+size_t svb_encode(void *buf, const uint32_t in[], size_t n);
+size_t svb_decode(uint32_t out[], const void *buf, size_t len, size_t n);
+
+/* Append to a strbuf; return like the strbuf_add functions */
+int varint_add(strbuf *sp, uint64_t v);
+int svb_add(strbuf *sp, const uint32_t in[], size_t n);
+
+/* Append the varint of v to b, a buf.h array of unsigned char;
+ * include "buf.h" to use it (not included here, since buf.h
+ * defines a static function that other users would not use) */
+#define varint_bufput(b, v) do { \
+    if (buf_capacity(b) - buf_size(b) < VARINT_MAX) \
+      buf_grow(b, buf_capacity(b) + VARINT_MAX); \
+    buf_ptr(b)->size += varint_put((b) + buf_size(b), (v)); \
+  } while (0)
+
+#endif
@@ -0,0 +1,127 @@
+/* Unit tests for varint.{c,h} */
+
+#include "test.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#include "buf.h"
+#include "strbuf.h"
+#include "varint.h"
+
+static int
+roundtrip(uint64_t v)
+{
+  unsigned char buf[VARINT_MAX];
+  uint64_t w = ~v;
+  size_t n = varint_put(buf, v);
+  return n == varint_len(v) && n == varint_put(0, v) &&
+         varint_get(buf, n, &w) == n && w == v &&
+         varint_get(buf, n-1, &w) == 0;
+}
+
+static int
+sroundtrip(int64_t v)
+{
+  unsigned char buf[VARINT_MAX];
+  int64_t w = ~v;
+  size_t n = svarint_put(buf, v);
+  return svarint_get(buf, n, &w) == n && w == v;
+}
+
+void
+varint_test(int *pnumpass, int *pnumfail)
+{
+  int numpass = 0;
+  int numfail = 0;
+
+  unsigned char buf[64];
+  uint32_t in[103], out[103];
+  uint64_t v;
+  size_t i, n, len;
+  int ok;
+
+  HEADING("Testing varint");
+
+  TEST("put 0", varint_put(buf, 0) == 1 && buf[0] == 0);
+  TEST("put 127", varint_put(buf, 127) == 1 && buf[0] == 127);
+  TEST("put 300", varint_put(buf, 300) == 2 && buf[0] == 0xAC && buf[1] == 0x02);
+  TEST("put max", varint_put(buf, UINT64_MAX) == 10 && buf[9] == 1);
+  TEST("len", varint_len(0) == 1 && varint_len(128) == 2 &&
+       varint_len(UINT64_C(1) << 63) == 10);
+  for (ok = 1, i = 0; i < 64; i++) {
+    ok &= roundtrip(UINT64_C(1) << i);
+    ok &= roundtrip((UINT64_C(1) << i) - 1);
+    ok &= roundtrip(UINT64_MAX >> i);
+  }
+  TEST("roundtrip", ok);
+  TEST("get empty", varint_get(buf, 0, &v) == 0 && varint_get(0, 5, &v) == 0);
+  memset(buf, 0xFF, 11);
+  TEST("get too long", varint_get(buf, 11, &v) == 0);
+  buf[9] = 0x02;
+  TEST("get overflow", varint_get(buf, 10, &v) == 0);
+  buf[0] = 0x80, buf[1] = 0;
+  TEST("get padded", varint_get(buf, 2, &v) == 2 && v == 0);
+
+  TEST("zigzag", zigzag(0) == 0 && zigzag(-1) == 1 && zigzag(1) == 2 &&
+       zigzag(-2) == 3 && zigzag(INT64_MAX) == UINT64_MAX - 1 &&
+       zigzag(INT64_MIN) == UINT64_MAX);
+  TEST("unzigzag", unzigzag(0) == 0 && unzigzag(1) == -1 && unzigzag(2) == 1 &&
+       unzigzag(UINT64_MAX) == INT64_MIN && unzigzag(UINT64_MAX - 1) == INT64_MAX);
+  TEST("svarint", sroundtrip(0) && sroundtrip(-1) && sroundtrip(63) &&
+       sroundtrip(-64) && sroundtrip(INT64_MIN) && sroundtrip(INT64_MAX));
+  TEST("svarint short", svarint_put(buf, -64) == 1 && svarint_put(buf, 64) == 2);
+
+  HEADING("Testing stream vbyte");
+
+  for (i = 0; i < 103; i++) /* mix of 1..4 byte values */
+    in[i] = (uint32_t) (i * 2654435761u) >> (i % 4 * 8);
+  {
+    unsigned char enc[SVB_MAX(103)];
+    len = svb_encode(enc, in, 103);
+    TEST("encode len", len == svb_encode(0, in, 103) && len <= SVB_MAX(103) && len > 26 + 103);
+    memset(out, 0, sizeof out);
+    TEST("decode", svb_decode(out, enc, len, 103) == len && memcmp(in, out, sizeof in) == 0);
+    for (ok = 1, n = 0; n <= 20; n++) { /* short inputs, every tail */
+      size_t m = svb_encode(enc, in + n, n);
+      memset(out, 0, sizeof out);
+      ok &= svb_decode(out, enc, m, n) == m && memcmp(in + n, out, n * sizeof *in) == 0;
+      ok &= n == 0 || svb_decode(out, enc, m - 1, n) == 0;
+    }
+    TEST("decode tails", ok);
+    TEST("decode truncated", svb_decode(out, enc, len - 1, 103) == 0 &&
+         svb_decode(out, enc, 10, 103) == 0);
+    in[0] = 0, in[1] = 0xFF, in[2] = 0x100, in[3] = 0xFFFFFFFF;
+    TEST("encode bytes", svb_encode(enc, in, 4) == 1 + 1 + 1 + 2 + 4 &&
+         enc[0] == (0 | 0 << 2 | 1 << 4 | 3 << 6) && enc[1] == 0 && enc[2] == 0xFF);
+  }
+
+  HEADING("Testing varint into strbuf and buf");
+
+  {
+    strbuf sb = {0};
+    unsigned char *b = 0;
+    uint32_t vals[3] = {1, 1000, 1000000};
+
+    ok = varint_add(&sb, 300) && varint_add(&sb, 1);
+    TEST("strbuf", ok && sblen(&sb) == 3 && (unsigned char) sbchar(&sb, 0) == 0xAC);
+    ok = svb_add(&sb, vals, 3);
+    n = varint_get(sbptr(&sb), sblen(&sb), &v);
+    TEST("strbuf svb", ok && n == 2 && v == 300 &&
+         svb_decode(out, sbptr(&sb) + 3, sblen(&sb) - 3, 3) == sblen(&sb) - 3 &&
+         out[0] == 1 && out[1] == 1000 && out[2] == 1000000);
+    sbfree(&sb);
+
+    for (i = 0; i < 100; i++) varint_bufput(b, (uint64_t) i << (i % 64));
+    for (ok = 1, n = 0, i = 0; i < 100; i++) {
+      len = varint_get(b + n, buf_size(b) - n, &v);
+      ok &= len > 0 && v == (uint64_t) i << (i % 64);
+      n += len;
+    }
+    TEST("buf", ok && n == buf_size(b));
+    buf_free(b);
+  }
+
+  *pnumpass += numpass;
+  *pnumfail += numfail;
+}